@@ -3,7 +3,9 @@
 /*
 User:
 -Must have a unique username
+-Has a dense ID (0, 1, 2, ...) assigned by the graph when it is loaded; everything internal keys on the ID
 -Members:
+    -id (uint32_t)
     -username (string)
     -firstname (string)
     -lastname (string)
@@ -11,28 +13,50 @@ User:
     -numFollowers (int)
     -following (adjList)
     -followers (adjList)
+    -mem (memArena*) (the graph's pools, or nullptr for a user made on its own)
 -Methods:
     -follow (user*) - follows user and adds self to the other person's followers
-    -unfollow (string) - unfollows user and removes self from other person's followers
+    -unfollow (user*) - unfollows user and removes self from other person's followers
 -Whenever someone is followed or unfollowed, his numFollowers is adjusted
 -Whenever someone follows or unfollows, his numFollowing is adjusted
 -The graph should deal primarily with users rather than adjLists because each user's adjList is a member of it.
 -The constructor creates the adjacency list for the member.
 
+Memory arena:
+-A graph owns one memArena: slab pools (see pool.h) for its users, their adjLists and every aNode
+-Users made with an arena take their lists and nodes from its pools; users made without one fall back to new/delete
+-Each follow then costs two pool slots instead of two heap allocations
+-When the graph goes away it sets dropping, destroys the users (which then only frees their strings and
+    membership indexes, since no node needs returning to its pool) and releases whole slabs at once
+
 Adjacency list:
 -List of users that someone is following
--Head stores the person himself
--All users in list are stored as pointers so that they will be updated when changed elsewhere in graph
--Each following node represents someone connected to head
+-The list knows the person it belongs to
+-Each node holds the 32-bit ID of someone connected to that person (the graph's users array turns it into a user)
+-A node is the ID and a next pointer, 16 bytes with padding, so each follow costs two 16-byte pool slots
+    plus its share of the two membership indexes (below) once the lists are long
 -Since a user can add, remove, and view connections, here are the methods:
     -Add (bool) (bool to see whether it happened)
+    -AddBatch (for bulk loads: many IDs known not to be in the list yet, with one index rebuild at the end)
     -Remove (bool) (bool to see whether it happened)
-    -View (user*) (* to allow for use of actual user)
+    -Contains (bool) (whether an ID is in the list)
 -Users can also view their own profiles, adding this method:
     -Self (user*) (* to allow for use of actual user)
 -Additionally, it is important to use the list quickly for connections without knowledge of names
     As a result, the following method is needed:
-    -getArr (user**) (This ptr has a dynamic array. Be sure to delete it!)
+    -first (aNode*) (Walks the list in place, with no array to allocate or delete)
+-Membership index:
+    -Once a list holds more than a few connections, it also keeps an open-addressing hash table of its nodes, keyed by user ID
+    -Add, Remove and Contains then find a connection by ID in O(1) expected time instead of scanning the whole list
+    -Lists are only searched by ID: a username is turned into an ID once, through the graph's vertex index
+    -So adjList and user have no username overloads (a list can't find a name without scanning its users);
+        the string API is the graph's thin lookup layer on top: follow/unfollow(string), userIndex and username
+    -Probes compare the IDs in the nodes, so a lookup never touches the users themselves
+    -Remove unlinks without a scan or back links: the first node's ID moves into the removed node, and the first node goes
+    -Rekey changes a user's ID in the list (and moves their index entry) when the graph renumbers them (after another user is removed)
+    -Short lists skip the table, since scanning a handful of nodes is just as fast
+-With GRAPH_STATS defined, every lookup (Contains, and the ones inside Add, Remove and Rekey) records how many nodes
+    or index slots it looked at (see stats.h)
 -Finally, a constructor and destructor are needed.
 
 Note on organization of adjList.h:
@@ -42,33 +66,57 @@ After all this, adjList's member methods could be written.
 In order to have circular dependencies, something along these lines must occur.
 */
 #include <string>
+#include <cstdint>
+#include <utility>
+#include "pool.h"
+#include "stats.h"
 using namespace std;
 
 struct user;  // Forward declaration of user structure
+struct memArena;  // Forward declaration of the pools a graph allocates from
 
 struct aNode {  // Structure for adjacency list node
-    user* val;  // Pointer to a user
+    uint32_t id;  // ID of the connected user
     aNode* next;  // Pointer to the next node in the list
 
-    aNode(user* person) : val(person), next(nullptr) {}  // Constructor to initialize the node with a user and set next to nullptr
+    aNode(uint32_t uid) : id(uid), next(nullptr) {}  // Constructor to initialize the node with a user ID and set next to nullptr
 };
 
 class adjList {  // Class for adjacency list
 private:
-    aNode* head;  // Pointer to the head of the list
+    user* owner;  // The user the list belongs to
+    aNode* head;  // Pointer to the first node of the list (nullptr while it is empty)
+    int count;  // Number of connections in the list
+    aNode** index;  // Open-addressing hash table of the nodes, keyed by user ID (nullptr while the list is short)
+    size_t cap;  // Number of slots in the index (a power of two)
+
+    static const int indexAt = 8;  // Lists longer than this get an index
+
+    size_t slotOf(uint32_t id) const;  // Home slot of an ID in the index
+    aNode* find(uint32_t id) const;  // Find the node for a user ID
+    size_t slotFor(aNode* node) const;  // Find the index slot holding a node
+    void indexInsert(aNode* node);  // Put a node into the index
+    void eraseSlot(size_t i);  // Empty slot i of the index, closing the gap
+    void rebuildIndex(size_t newCap);  // Rebuild the index with newCap slots
+    aNode* newNode(uint32_t id);  // Make a node (from the arena, if the list's user has one)
+    void freeNode(aNode* node);  // Free a node made by newNode
 public:
     adjList(user* person);  // Constructor
     ~adjList();  // Destructor
 
-    bool add(user* person);  // Add a user to the list
-    bool remove(string username);  // Remove a user by username
-    user* view(string username) const;  // View a user by username
-    user* self() const;  // Get the current user (head of the list)
+    bool add(uint32_t id);  // Add a user to the list by ID
+    void addBatch(const uint32_t* ids, int len, memPool<aNode>* pool = nullptr);  // Add IDs that are not in the list yet (no duplicate checks), with nodes from pool if given
+    bool remove(uint32_t id);  // Remove a user by ID
+    bool contains(uint32_t id) const;  // Whether a user is in the list
+    void rekey(uint32_t oldId, uint32_t newId);  // Change a user's ID in the list from oldId to newId
+    int size() const;  // Get the number of connections in the list
+    user* self() const;  // Get the user the list belongs to
 
-    user** getArr(int len);  // Get an array of users in the list
+    aNode* first() const;  // Get the first connection (nullptr if there are none)
 };
 
 struct user {  // Structure for user
+    uint32_t id;  // Dense ID of the user (their index in the graph)
     string username;  // Username of the user
     string firstname;  // First name of the user
     string lastname;  // Last name of the user
@@ -77,131 +125,230 @@ struct user {  // Structure for user
 
     adjList* following;  // Adjacency list of users this user is following
     adjList* followers;  // Adjacency list of users following this user
+    memArena* mem;  // Pools this user and its lists come from (nullptr if it was made with new)
 
     bool follow(user* usr);  // Follow another user
-    bool unfollow(string uname);  // Unfollow a user by username
+    bool unfollow(user* usr);  // Unfollow another user
 
-    user(string un, string fn, string ln);  // Constructor to initialize user with username, firstname, and lastname
-    ~user();  // Destructor
+    user(uint32_t i, string un, string fn, string ln, memArena* m = nullptr);  // Constructor to initialize user with ID, username, firstname, lastname, and (optionally) the arena to use
+    ~user();  // Destructor (the lists' nodes only hold IDs, so the graph unlinks a user's edges first; see graph::removeUser)
 };
 
-user::user(string un, string fn, string ln) : username(un), firstname(fn), lastname(ln), numFollowing(0), numFollowers(0) {  // Initialize user fields and set following/followers lists
-    following = new adjList(this);  // Create adjacency list for following
-    followers = new adjList(this);  // Create adjacency list for followers
+struct memArena {  // Pools for everything a graph allocates per user and per follow
+    memPool<aNode> nodes;  // Adjacency list nodes (two per follow)
+    memPool<adjList> lists;  // Following and followers lists (two per user)
+    memPool<user> users;  // The users themselves
+    bool dropping;  // Set right before the pools are released: destructors skip freeing nodes one by one
+
+    memArena() : dropping(false) {}
+    void release() {  // Drop every pool at once (the users must have been destroyed with dropping set)
+        nodes.release();
+        lists.release();
+        users.release();
+        dropping = false;
+    }
+};
+
+user::user(uint32_t i, string un, string fn, string ln, memArena* m) : id(i), username(move(un)), firstname(move(fn)), lastname(move(ln)), numFollowing(0), numFollowers(0), mem(m) {  // Initialize user fields and set following/followers lists
+    following = mem ? mem->lists.make(this) : new adjList(this);  // Create adjacency list for following
+    followers = mem ? mem->lists.make(this) : new adjList(this);  // Create adjacency list for followers
 }
 
 user::~user() {  // Destructor for user
-    user** temp = following->getArr(numFollowing);  // Get the array of users this user is following
-    while(numFollowing) {  // Unfollow all users
-        unfollow(temp[numFollowing - 1]->username);  // Unfollow the last user in the array
-    }
-    delete[] temp;  // Delete the temporary array
-
-    temp = followers->getArr(numFollowers);  // Get the array of users following this user
-    while(numFollowers) {  // Remove all followers
-        temp[numFollowers - 1]->unfollow(this->username);  // Unfollow this user for each follower
+    if (mem) {  // Give the lists back to the arena
+        mem->lists.destroy(following);
+        mem->lists.destroy(followers);
+    } else {
+        delete following;  // Delete the following list
+        delete followers;  // Delete the followers list
     }
-    delete[] temp;  // Delete the temporary array
-
-    delete following;  // Delete the following list
-    delete followers;  // Delete the followers list
 }
 
 bool user::follow(user* usr) {  // Follow another user
     bool ret = 1;  // Initialize return value to true
 
-    if(following->add(usr))  // Add user to following list
+    if(following->add(usr->id))  // Add user to following list
         numFollowing++;  // Increment number of following
     else ret = 0;  // Set return value to false if addition failed
 
-    if(usr->followers->add(this))  // Add this user to the other's followers list
+    if(usr->followers->add(id))  // Add this user to the other's followers list
         usr->numFollowers++;  // Increment number of followers
     else ret = 0;  // Set return value to false if addition failed
 
     return ret;  // Return whether the follow operation was successful
 }
 
-bool user::unfollow(string uname) {  // Unfollow a user by username
+bool user::unfollow(user* usr) {  // Unfollow another user
     bool ret = 1;  // Initialize return value to true
 
-    user* usr = following->view(uname);  // Find the user in the following list
-    if(usr && following->remove(uname))  // If user is found and removed, decrement numFollowing
+    if(following->remove(usr->id))  // If the user is removed from the following list, decrement numFollowing
         numFollowing--;
     else ret = 0;  // Set return value to false if removal failed
     
-    if(usr && usr->followers->remove(username))  // If this user is removed from the other's followers list, decrement numFollowers
+    if(usr->followers->remove(id))  // If this user is removed from the other's followers list, decrement numFollowers
         usr->numFollowers--;
     else ret = 0;  // Set return value to false if removal failed
 
     return ret;  // Return whether the unfollow operation was successful
 }
 
-adjList::adjList(user* person) {  // Constructor for adjacency list
-    head = new aNode(person);  // Initialize the head node with the user
-}
+const int adjList::indexAt;
+
+adjList::adjList(user* person) : owner(person), head(nullptr), count(0), index(nullptr), cap(0) {}  // Constructor for adjacency list
 
 adjList::~adjList() {  // Destructor for adjacency list
+    memArena* mem = owner->mem;  // Arena the nodes came from (if any)
     aNode* temp;  // Temporary node pointer
-    while(head) {  // Traverse and delete all nodes
+    while(head && !(mem && mem->dropping)) {  // Traverse and delete all nodes (unless the arena is dropping them all at once)
         temp = head->next;  // Move to the next node
-        delete head;  // Delete the current node
+        freeNode(head);  // Delete the current node
         head = temp;  // Update head to the next node
     }
+    delete[] index;  // Delete the membership index (if there is one)
 }
 
-bool adjList::add(user* person) {  // Add a user to the adjacency list
-    if (person == head->val || view(person->username)) return false;  // If user is already in the list, return false
-    aNode* temp = new aNode(person);  // Create a new node for the user
-    temp->next = head->next;  // Insert the new node after the head
-    head->next = temp;  // Update the next pointer of the head
-    return true;  // Return true if the user was added successfully
+aNode* adjList::newNode(uint32_t id) {  // Make a node from the arena of the list's user, or with new
+    return owner->mem ? owner->mem->nodes.make(id) : new aNode(id);
 }
 
-bool adjList::remove(string username) {  // Remove a user by username
-    aNode* cur = head;  // Current node pointer
-    aNode* next = head->next;  // Pointer to the next node
-    
-    while(next && next->val->username != username) {  // Traverse the list until the user is found
-        cur = next;  // Move to the next node
-        next = cur->next;  // Update next pointer
+void adjList::freeNode(aNode* node) {  // Free a node made by newNode
+    if (owner->mem) owner->mem->nodes.destroy(node);
+    else delete node;
+}
+
+size_t adjList::slotOf(uint32_t id) const {  // Home slot of an ID in the index
+    return (size_t)((id * 0x9E3779B97F4A7C15ull) >> 32) & (cap - 1);  // Fibonacci hashing spreads consecutive IDs out
+}
+
+aNode* adjList::find(uint32_t id) const {  // Find the node for a user ID
+    int scanned = 0;  // Nodes (or index slots) looked at, for the stats
+    if(!index) {  // Short list: scan it
+        aNode* cur = head;  // Start from the first node
+        while(cur && cur->id != id) {  // Traverse the list until the user is found
+            cur = cur->next;
+            scanned++;
+        }
+        STAT_RECORD(statViewId, scanned + (cur != nullptr));
+        return cur;  // Return the node, or nullptr if the user is not found
     }
 
-    if(next) {  // If the user is found
-        cur->next = next->next;  // Remove the node from the list
-        delete next;  // Delete the node
-        return 1;  // Return true if removal was successful
+    for(size_t i = slotOf(id); index[i]; i = (i + 1) & (cap - 1)) {  // Linear probing until an empty slot
+        scanned++;
+        if(index[i]->id == id) {  // Found the user
+            STAT_RECORD(statViewId, scanned);
+            return index[i];
+        }
     }
-    
-    return 0;  // Return false if the user was not found
+    STAT_RECORD(statViewId, scanned);
+    return nullptr;  // Hit an empty slot, so the user is not in the list
+}
+
+size_t adjList::slotFor(aNode* node) const {  // Find the index slot holding a node
+    size_t i = slotOf(node->id);  // Home slot of the node
+    while(index[i] != node) i = (i + 1) & (cap - 1);  // Probe to the node's slot
+    return i;
 }
 
-user* adjList::view(string username) const {  // View a user by username
-    aNode* cur = head->next;  // Start from the first node
+void adjList::indexInsert(aNode* node) {  // Put a node into the index
+    size_t i = slotOf(node->id);  // Home slot of the node
+    while(index[i]) i = (i + 1) & (cap - 1);  // Probe to the first empty slot
+    index[i] = node;  // Store the node
+}
 
-    while(cur && cur->val->username != username) {  // Traverse the list until the user is found
-        cur = cur->next;  // Move to the next node
+void adjList::eraseSlot(size_t i) {  // Empty slot i of the index
+    // Backward-shift deletion: pull later entries of the probe run into the gap so no tombstones are needed
+    size_t j = i;
+    while(true) {
+        j = (j + 1) & (cap - 1);  // Next slot in the run
+        if(!index[j]) break;  // End of the run
+        size_t home = slotOf(index[j]->id);  // Where the entry would like to be
+        if(((j - home) & (cap - 1)) >= ((j - i) & (cap - 1))) {  // The gap lies between its home and its slot, so it can move back
+            index[i] = index[j];
+            i = j;
+        }
     }
+    index[i] = nullptr;  // Empty the final gap
+}
 
-    if(cur) return cur->val;  // If the user is found, return the user
-    return nullptr;  // Return nullptr if the user is not found
+void adjList::rebuildIndex(size_t newCap) {  // Rebuild the index with newCap slots
+    delete[] index;  // Drop the old table
+    cap = newCap;  // Store the new capacity
+    index = new aNode*[cap]();  // Allocate an empty table
+    for(aNode* cur = head; cur; cur = cur->next) indexInsert(cur);  // Re-insert every node
 }
 
-user* adjList::self() const {  // Get the current user (head of the list)
-    return head->val;  // Return the user stored in the head node
+bool adjList::add(uint32_t id) {  // Add a user to the adjacency list by ID
+    if (id == owner->id || find(id)) return false;  // If user is already in the list, return false
+
+    aNode* temp = newNode(id);  // Create a new node for the user
+    temp->next = head;  // Insert the new node at the front
+    head = temp;  // Update the head
+    count++;  // One more connection
+
+    if (count > indexAt && 2 * (size_t)count > cap) rebuildIndex(cap ? cap * 2 : 4 * indexAt);  // (Re)build the index to keep its load at or below one half; this also indexes the new node
+    else if (index) indexInsert(temp);  // Keep the index up to date
+    return true;  // Return true if the user was added successfully
+}
+
+// A pool lets threads fill different lists at once: each takes nodes from its own pool, which the graph's arena absorbs afterwards
+void adjList::addBatch(const uint32_t* ids, int len, memPool<aNode>* pool) {  // Add a batch of IDs already known to be new (e.g. deduped by graph::bulkFollow)
+    for (int i = 0; i < len; i++) {  // Link each one in at the front, as add does
+        aNode* temp = pool ? pool->make(ids[i]) : newNode(ids[i]);
+        temp->next = head;
+        head = temp;
+    }
+    count += len;
+
+    if (count <= indexAt) return;  // Still short enough to scan
+    if (index && 2 * (size_t)count <= cap) {  // The index has room: just add the new nodes
+        aNode* cur = head;
+        for (int i = 0; i < len; i++, cur = cur->next) indexInsert(cur);
+        return;
+    }
+    size_t newCap = cap ? cap : 4 * indexAt;  // Otherwise rebuild it once, big enough for everything
+    while (2 * (size_t)count > newCap) newCap *= 2;
+    rebuildIndex(newCap);
 }
 
-user** adjList::getArr(int len) {  // Get an array of users in the list
-    user** arr = new user*[len];  // Create a new array of user pointers
-    aNode* cur = head->next;  // Start from the first node
-    int i;  // Loop counter
-    for(i = 0; cur; i++) {  // Traverse the list and store users in the array
-        arr[i] = cur->val;  // Store the user in the array
-        cur = cur->next;  // Move to the next node
+bool adjList::remove(uint32_t id) {  // Remove a user by ID
+    aNode* node = find(id);  // Find the user's node
+    if(!node) return 0;  // Return false if the user was not found
+
+    // There are no back links, so the first node's ID moves into this node and the first node is unlinked instead
+    aNode* front = head;
+    if(index) eraseSlot(slotFor(node));  // Take the node out of the index
+    if(node != front) {
+        if(index) index[slotFor(front)] = node;  // The front ID's entry stays in its slot but now points at its new node
+        node->id = front->id;
     }
+    head = front->next;  // Unlink the first node
+    freeNode(front);  // Delete it
+    count--;  // One fewer connection
+    return 1;  // Return true if removal was successful
+}
 
-    if(i != len) cout << "WARNING: len = " << len << ", but i = " << i << endl;  // Warning if the array length is incorrect
+bool adjList::contains(uint32_t id) const {  // Whether a user is in the list
+    return find(id) != nullptr;
+}
+
+void adjList::rekey(uint32_t oldId, uint32_t newId) {  // The user's ID changed (see graph::removeUser): update their node and move its index entry
+    aNode* node = find(oldId);
+    if(!node) return;
+    if(index) eraseSlot(slotFor(node));  // Other entries' homes still come from their (unchanged) IDs
+    node->id = newId;
+    if(index) indexInsert(node);
+}
+
+int adjList::size() const {  // Get the number of connections in the list
+    return count;  // Return the connection count
+}
+
+user* adjList::self() const {  // Get the user the list belongs to
+    return owner;  // Return the owner
+}
 
-    return arr;  // Return the array of users
+aNode* adjList::first() const {  // Get the first connection
+    return head;  // Return the first node, or nullptr if the list is empty
 }
 
-#endif
\ No newline at end of file
+#endif
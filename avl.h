@@ -6,9 +6,21 @@ AVL:
 -Used for graph to have easy access to each adjacency list and user
 -Very normal AVL tree
 -Stores users as pointers
+-Insert, remove and retrieve are iterative and descend the tree once:
+    -The descent records the link (parent's child pointer) to every node it passes
+    -Insert and remove then walk those links back up, fixing heights and rotating where needed
+-A whole batch of users can be bulk-loaded in O(n): the sorted batch is split at its middle recursively,
+    which gives a perfectly balanced tree with no rotations
+-Tree nodes come from the tree's own slab pool (see pool.h), so destroying the tree frees a few slabs
+    instead of removing and deleting every node
+-With GRAPH_STATS defined, retrieve records how deep each lookup went and how many missed (see stats.h)
 */
 
+#include <algorithm>
+#include <vector>
 #include "adjList.h"
+#include "pool.h"
+#include "stats.h"
 using namespace std;
 
 // Node structure for an AVL tree
@@ -25,53 +37,150 @@ struct tNode {
 class AVL {
 private:
     tNode* head;  // Pointer to the root node of the AVL tree
+    memPool<tNode> pool;  // Where the tree's nodes are allocated
 
-    tNode* insertRec(tNode* node, user* v);  // Recursive method to insert and balance the tree
-    user* retrieveRec(tNode* node, string k) const;  // Recursive method to retrieve a user by username
-    tNode* removeRec(tNode* node, string k);  // Recursive method to remove and balance the tree
-    void getArrRec(tNode* node, user** arr, int* i) const;  // Recursive method to fill an array with users in the tree
+    static const int maxDepth = 64;  // Deeper than any AVL tree that fits in memory (about 1.44 * log2(n))
+
+    tNode* buildRec(user** arr, int lo, int hi);  // Recursive method to build a balanced subtree from sorted users
+    void rebalance(tNode** links[], int depth);  // Fix heights and rotate along a recorded path, deepest link first
 
     int height(tNode* N);  // Utility method to return the height of a node
     tNode* rotateRight(tNode* y);  // Utility method for right rotation
     tNode* rotateLeft(tNode* x);  // Utility method for left rotation
     int getBalance(tNode* N);  // Utility method to get the balance factor of a node
+    tNode* balance(tNode* node);  // Utility method to update a node's height and rotate it if unbalanced
 
 public:
     AVL();  // Constructor
+    AVL(user** arr, int len, bool sorted = false);  // Bulk-load constructor
     ~AVL();  // Destructor
 
     user** getArr(int len) const;  // Method to get an array of all users in the tree
+    int bulkLoad(user** arr, int len, bool sorted = false);  // Method to build an empty tree from a batch of users
+    void clear();  // Method to empty the tree
     bool insert(user* k);  // Method to insert a user into the tree
-    bool remove(string k);  // Method to remove a user by username
-    user* retrieve(string k) const;  // Method to retrieve a user by username
+    bool remove(const string& k);  // Method to remove a user by username
+    user* retrieve(const string& k) const;  // Method to retrieve a user by username
 };
 
+const int AVL::maxDepth;
+
 AVL::AVL() : head(nullptr) {}  // Constructor to initialize the AVL tree with an empty head
 
-AVL::~AVL() {  // Destructor for the AVL tree
-    while (head) remove(head->val->username);  // Remove all nodes in the tree
+AVL::AVL(user** arr, int len, bool sorted) : head(nullptr) {  // Bulk-load constructor
+    bulkLoad(arr, len, sorted);  // Build the tree from the batch
+}
+
+AVL::~AVL() {}  // Destructor for the AVL tree (the pool frees every node at once)
+
+void AVL::clear() {  // Empty the tree by dropping the node pool
+    pool.release();
+    head = nullptr;
+}
+
+int AVL::bulkLoad(user** arr, int len, bool sorted) {  // Build an empty tree from a batch of users in O(n) (plus a sort if needed)
+    if (head) return 0;  // Only an empty tree can be bulk-loaded
+
+    // Sort a copy of the batch by username unless it already is, and drop repeated usernames (the first one wins)
+    vector<user*> batch(arr, arr + len);
+    if (!sorted) stable_sort(batch.begin(), batch.end(), [](user* a, user* b) { return a->username < b->username; });
+    batch.erase(unique(batch.begin(), batch.end(), [](user* a, user* b) { return a->username == b->username; }), batch.end());
+
+    head = buildRec(batch.data(), 0, (int)batch.size());  // Build the balanced tree
+    return (int)batch.size();  // Return the number of users loaded
+}
+
+tNode* AVL::buildRec(user** arr, int lo, int hi) {  // Recursive method to build a balanced subtree from arr[lo, hi)
+    if (lo >= hi) return nullptr;  // Empty range, empty subtree
+    int mid = lo + (hi - lo) / 2;  // The middle user becomes the root
+    tNode* node = pool.make(arr[mid]);
+    node->left = buildRec(arr, lo, mid);  // Users before the middle go left
+    node->right = buildRec(arr, mid + 1, hi);  // Users after the middle go right
+    node->height = 1 + max(height(node->left), height(node->right));  // Height of the new subtree
+    return node;  // Return the root of the subtree
 }
 
 bool AVL::insert(user* k) {  // Insert a user into the AVL tree
-    if (retrieve(k->username)) return false;  // If the user already exists, return false
-    head = insertRec(head, k);  // Insert the user and update the tree
+    tNode** links[maxDepth];  // Links followed on the way down
+    int depth = 0;
+    tNode** link = &head;  // Start at the root
+
+    // Single descent: find the empty spot for the user, or stop if the username is taken
+    while (*link) {
+        links[depth++] = link;  // Record the link to this node
+        if (k->username < (*link)->val->username) link = &(*link)->left;  // Go left
+        else if (k->username > (*link)->val->username) link = &(*link)->right;  // Go right
+        else return false;  // If the user already exists, return false
+    }
+
+    *link = pool.make(k);  // Hang the new node in the empty spot
+    rebalance(links, depth);  // Fix the path back up to the root
     return true;  // Return true if insertion was successful
 }
 
-bool AVL::remove(string k) {  // Remove a user from the AVL tree by username
-    if (!retrieve(k)) return false;  // If the user doesn't exist, return false
-    head = removeRec(head, k);  // Remove the user and update the tree
+bool AVL::remove(const string& k) {  // Remove a user from the AVL tree by username
+    tNode** links[maxDepth];  // Links followed on the way down
+    int depth = 0;
+    tNode** link = &head;  // Start at the root
+
+    // Single descent to the node holding the username
+    while (*link && (*link)->val->username != k) {
+        links[depth++] = link;  // Record the link to this node
+        link = (k < (*link)->val->username) ? &(*link)->left : &(*link)->right;  // Go left or right
+    }
+    if (!*link) return false;  // If the user doesn't exist, return false
+
+    tNode* node = *link;  // Node to remove
+    if (node->left && node->right) {  // Node with two children: swap in the smallest user of the right subtree
+        links[depth++] = link;  // The node stays in place, so it is on the path to fix
+        tNode** succ = &node->right;  // Find the smallest node in the right subtree
+        while ((*succ)->left) {
+            links[depth++] = succ;  // Record the link to this node
+            succ = &(*succ)->left;  // Traverse to the leftmost node
+        }
+        node->val = (*succ)->val;  // Copy the value of the smallest node
+        link = succ;  // Remove the smallest node instead
+        node = *succ;
+    }
+
+    *link = node->left ? node->left : node->right;  // Replace the node with its only child (if any)
+    pool.destroy(node);  // Delete the node
+    rebalance(links, depth);  // Fix the path back up to the root
     return true;  // Return true if removal was successful
 }
 
-user* AVL::retrieve(string k) const {  // Retrieve a user from the AVL tree by username
-    return retrieveRec(head, k);  // Call the recursive method to retrieve the user
+user* AVL::retrieve(const string& k) const {  // Retrieve a user from the AVL tree by username
+    tNode* node = head;  // Start at the root
+    int depth = 0;  // Nodes compared so far (for the stats)
+    while (node) {  // Walk down until the user is found or we fall off the tree
+        depth++;
+        if (k < node->val->username) node = node->left;  // Search in the left subtree
+        else if (k > node->val->username) node = node->right;  // Search in the right subtree
+        else {
+            STAT_RECORD(statAvlRetrieve, depth);
+            return node->val;  // If the user is found, return the user
+        }
+    }
+    STAT_RECORD(statAvlRetrieve, depth);
+    STAT_COUNT(statAvlMiss);
+    return nullptr;  // User not found
 }
 
-user** AVL::getArr(int len) const {  // Get an array of all users in the AVL tree
+user** AVL::getArr(int len) const {  // Get an array of all users in the AVL tree (in username order)
     user** arr = new user*[len];  // Create an array of user pointers
+    tNode* stack[maxDepth];  // Nodes whose left subtree is being visited
+    int top = 0;  // Stack size
     int i = 0;  // Initialize index for array
-    getArrRec(head, arr, &i);  // Fill the array with users using recursion
+    tNode* node = head;
+    while (node || top) {  // In-order traversal with an explicit stack
+        while (node) {  // Go as far left as possible
+            stack[top++] = node;
+            node = node->left;
+        }
+        node = stack[--top];  // Visit the node
+        if (i < len) arr[i++] = node->val;  // Add the user to the array
+        node = node->right;  // Then visit its right subtree
+    }
     return arr;  // Return the array of users
 }
 
@@ -115,86 +224,13 @@ int AVL::getBalance(tNode* N) {  // Utility method to get the balance factor of
     return height(N->left) - height(N->right);  // Return the difference in height between left and right subtrees
 }
 
-tNode* AVL::insertRec(tNode* node, user* v) {  // Recursive method to insert and balance the tree
-    if (!node) return new tNode(v);  // If the node is null, create a new tree node with the user
-
-    // Insert the user into the correct subtree
-    if (v->username < node->val->username)
-        node->left = insertRec(node->left, v);  // Insert in the left subtree
-    else if (v->username > node->val->username)
-        node->right = insertRec(node->right, v);  // Insert in the right subtree
-    else return node;  // If the username is the same, return the current node (no duplicates)
-
+tNode* AVL::balance(tNode* node) {  // Update a node's height and rotate it if it is unbalanced
     // Update the height of this node
     node->height = 1 + max(height(node->left), height(node->right));
 
     // Get the balance factor of this node
     int balance = getBalance(node);
 
-    // If the node is unbalanced, perform rotations
-    if (balance > 1 && v->username < node->left->val->username)  // Left Left case
-        return rotateRight(node);
-    if (balance < -1 && v->username > node->right->val->username)  // Right Right case
-        return rotateLeft(node);
-    if (balance > 1 && v->username > node->left->val->username) {  // Left Right case
-        node->left = rotateLeft(node->left);
-        return rotateRight(node);
-    }
-    if (balance < -1 && v->username < node->right->val->username) {  // Right Left case
-        node->right = rotateRight(node->right);
-        return rotateLeft(node);
-    }
-
-    return node;  // Return the (potentially) balanced node
-}
-
-user* AVL::retrieveRec(tNode* node, string k) const {  // Recursive method to retrieve a user by username
-    if (!node) return nullptr;  // If the node is null, return null (user not found)
-
-    // Traverse the tree to find the user
-    if (k < node->val->username)
-        return retrieveRec(node->left, k);  // Search in the left subtree
-    if (k > node->val->username)
-        return retrieveRec(node->right, k);  // Search in the right subtree
-
-    return node->val;  // If the user is found, return the user
-}
-
-tNode* AVL::removeRec(tNode* node, string k) {  // Recursive method to remove and balance the tree
-    if (!node) return node;  // If the node is null, return null
-
-    // Traverse the tree to find the user to remove
-    if (k < node->val->username)
-        node->left = removeRec(node->left, k);  // Remove from the left subtree
-    else if (k > node->val->username)
-        node->right = removeRec(node->right, k);  // Remove from the right subtree
-    else {  // User to be removed is found
-        if (!node->left || !node->right) {  // Node with only one child or no child
-            tNode* temp = node->left ? node->left : node->right;  // Get the non-null child (if any)
-            if (!temp) {  // If no child, just delete the node
-                temp = node;
-                node = nullptr;
-            }
-            else *node = *temp;  // Copy the contents of the non-empty child
-            delete temp;  // Delete the node
-        }
-        else {  // Node with two children
-            tNode* temp = node->right;  // Find the smallest node in the right subtree
-            while (temp->left) temp = temp->left;  // Traverse to the leftmost leaf
-
-            node->val = temp->val;  // Copy the value of the smallest node
-            node->right = removeRec(node->right, temp->val->username);  // Remove the smallest node
-        }
-    }
-
-    if (!node) return node;  // If the tree has only one node, return it
-
-    // Update the height of the current node
-    node->height = 1 + max(height(node->left), height(node->right));
-
-    // Get the balance factor of this node
-    int balance = getBalance(node);
-
     // If the node is unbalanced, perform rotations
     if (balance > 1 && getBalance(node->left) >= 0)  // Left Left case
         return rotateRight(node);
@@ -212,11 +248,14 @@ tNode* AVL::removeRec(tNode* node, string k) {  // Recursive method to remove an
     return node;  // Return the (potentially) balanced node
 }
 
-void AVL::getArrRec(tNode* node, user** arr, int* i) const {  // Recursive method to fill an array with users in the tree
-    if (!node) return;  // If the node is null, return
-    getArrRec(node->left, arr, i);  // Traverse the left subtree
-    arr[(*i)++] = node->val;  // Add the user to the array
-    getArrRec(node->right, arr, i);  // Traverse the right subtree
+void AVL::rebalance(tNode** links[], int depth) {  // Fix heights and rotate along a recorded path, deepest link first
+    while (depth--) {
+        tNode* node = *links[depth];  // Node on the path
+        int oldHeight = node->height;  // Height before the change below it
+        tNode* fixed = balance(node);  // Update and rotate if needed
+        *links[depth] = fixed;  // Hang the (possibly new) subtree root back on its parent
+        if (fixed == node && node->height == oldHeight) return;  // Nothing changed here, so nothing above changes either
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,330 @@
+/*
+Graph benchmark:
+-Times every graph operation on generated networks (see generator.h) of several sizes and prints one JSON document
+-Every size runs in its own child process, so its peak RSS is its own
+-Each size uses fixed seeds, so two revisions see exactly the same networks and queries
+-Operations:
+    -generate (build users and bulk-load the follows), freeze (pack the CSR snapshot), saveSnapshot, loadSnapshot
+    -retrieve (username -> user through the vertex index), sepDegree, suggestFriends, suggestFriendsAll,
+        mostConnected, mostInfluential, mostReaching
+    -suggestFriends asks about each user at most once, so every call runs the engine rather than being
+        answered from the suggestion cache
+    -firstEdit (the first follow after loading, which builds the adjacency lists), then follow and unfollow
+        (single edges on the adjacency lists)
+    -liveApply (a liveGraph publishing a batch of 1000 follow events as a new version, see liveGraph.h)
+    -ingest (see ingest.h): one follow per user staged by p producer threads, then compacted into the graph on
+        p threads, for p = 1, 2, 4, ... up to the core count; each p reports end-to-end follows/sec
+        (staging plus compaction) and the time spent in each phase
+-Every operation is timed one call at a time: the JSON has the call count, ops/sec, and p50/p99 latency in nanoseconds
+-Repeated operations run until they reach -reps calls or use up -budget seconds, whichever comes first
+-Options (all optional):
+    -users 250,10000,1000000,10000000   sizes to run
+    -degree 10                           follows per user
+    -model chunglu                       uniform, ba, rmat or chunglu
+    -seed 1                              network and query seed
+    -reps 100000                         most calls per repeated operation
+    -budget 2                            most seconds per repeated operation
+    -label name                          copied into the JSON (e.g. a git revision)
+    -snapshot path                       scratch file for the snapshot round trip (default bench.snap)
+-Progress goes to stderr, the JSON to stdout
+-Build: make bench
+*/
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "graph.h"
+#include "liveGraph.h"
+#include "ingest.h"
+#include "server.h"
+#include <thread>
+using namespace std;
+
+struct benchConfig {
+    vector<uint32_t> sizes;        // Network sizes to run
+    uint64_t degree;               // Follows per user
+    genModel model;                // Generator model
+    string modelName;              // Its command-line name
+    uint64_t seed;                 // Seed for the network and the queries
+    size_t reps;                   // Most calls per repeated operation
+    double budget;                 // Most seconds per repeated operation
+    string label;                  // Free-form label for the run
+    string snapshotPath;           // Scratch snapshot file
+
+    benchConfig() : sizes({250, 10000, 1000000, 10000000}), degree(10), model(genChungLu), modelName("chunglu"),
+                    seed(1), reps(100000), budget(2.0), snapshotPath("bench.snap") {}
+};
+
+// Latencies of one operation, in nanoseconds
+class opTimer {
+private:
+    string name;
+    vector<double> ns;
+    double total;                  // Seconds spent in the calls
+
+public:
+    opTimer(const string& n) : name(n), total(0) {}
+
+    template <typename F>
+    void time(F call) {  // Time one call
+        auto start = chrono::steady_clock::now();
+        call();
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ns.push_back(secs * 1e9);
+        total += secs;
+    }
+
+    template <typename F>
+    void repeat(const benchConfig& cfg, F call) {  // Time call(i) for i = 0, 1, ... until the count or time budget runs out
+        for (size_t i = 0; i < cfg.reps && (i == 0 || total < cfg.budget); i++) time([&]() { call(i); });
+    }
+
+    double percentile(double p) {  // Latency below which fraction p of the calls fall
+        if (ns.empty()) return 0;
+        size_t k = min(ns.size() - 1, (size_t)(p * ns.size()));
+        nth_element(ns.begin(), ns.begin() + k, ns.end());
+        return ns[k];
+    }
+
+    string json() {  // One entry of the "ops" array
+        ostringstream out;
+        out.setf(ios::fixed);
+        out.precision(1);
+        out << "{\"op\": \"" << name << "\", \"count\": " << ns.size() << ", \"opsPerSec\": " << (total > 0 ? ns.size() / total : 0)
+            << ", \"p50Ns\": " << percentile(0.50) << ", \"p99Ns\": " << percentile(0.99) << "}";
+        return out.str();
+    }
+};
+
+// Peak resident set size of this process, in KB
+long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // Linux reports KB
+}
+
+// Run every operation on one network size and print its JSON object
+void benchSize(const benchConfig& cfg, uint32_t n) {
+    genParams params(cfg.model, n, cfg.degree * n, cfg.seed);
+    vector<string> ops;
+    cerr << "users " << n << ": generate" << endl;
+
+    // Building and loading
+    graph* network = nullptr;
+    opTimer generate("generate");
+    generate.time([&]() { network = new graph(params); });
+    ops.push_back(generate.json());
+
+    opTimer freeze("freeze");
+    freeze.time([&]() { network->freeze(); });
+    ops.push_back(freeze.json());
+
+    cerr << "users " << n << ": snapshot" << endl;
+    opTimer save("saveSnapshot"), load("loadSnapshot");
+    bool saved = false;
+    save.time([&]() { saved = network->saveSnapshot(cfg.snapshotPath); });
+    if (saved) {
+        delete network;
+        load.time([&]() { network = new graph(cfg.snapshotPath); });
+        ops.push_back(save.json());
+        ops.push_back(load.json());
+        remove(cfg.snapshotPath.c_str());
+    } else cerr << "could not write " << cfg.snapshotPath << ", skipping the snapshot round trip" << endl;
+    graph& g = *network;
+
+    // The same queries every run
+    mt19937_64 gen(cfg.seed ^ 0x42454E43);
+    uniform_int_distribution<int> pick(0, n - 1);
+    size_t samples = min<size_t>(cfg.reps, 1 << 16);
+    vector<int> a(samples), b(samples);
+    vector<string> names(samples);
+    for (size_t i = 0; i < samples; i++) {
+        a[i] = pick(gen);
+        b[i] = pick(gen);
+        names[i] = genField(params, a[i], 0);
+    }
+
+    // Read-only queries (against the CSR snapshot)
+    cerr << "users " << n << ": queries" << endl;
+    volatile long sink = 0;  // Keeps results from being optimized away
+
+    opTimer retrieve("retrieve");
+    retrieve.repeat(cfg, [&](size_t i) { sink += g.userIndex(names[i % samples]); });
+    ops.push_back(retrieve.json());
+
+    opTimer sep("sepDegree");
+    sep.repeat(cfg, [&](size_t i) { sink += g.sepDegree(a[i % samples], b[i % samples]); });
+    ops.push_back(sep.json());
+
+    // Distinct users, in a seeded random order: a repeat would be a suggestion cache hit
+    vector<uint32_t> fresh(n);
+    for (uint32_t v = 0; v < n; v++) fresh[v] = v;
+    size_t distinct = min<size_t>(samples, n);
+    vector<string> freshNames(distinct);
+    for (size_t i = 0; i < distinct; i++) {
+        swap(fresh[i], fresh[i + gen() % (n - i)]);
+        freshNames[i] = g.username(fresh[i]);
+    }
+    benchConfig perUser = cfg;
+    perUser.reps = distinct;
+    opTimer suggest("suggestFriends");
+    suggest.repeat(perUser, [&](size_t i) { delete[] g.suggestFriends(freshNames[i], 5); });
+    ops.push_back(suggest.json());
+
+    opTimer suggestAll("suggestFriendsAll");  // One call makes 5 suggestions for every user, on every core
+    suggestAll.time([&]() {
+        vector<uint32_t> suggestions;
+        vector<int> found;
+        g.suggestFriendsAll(5, suggestions, found);
+    });
+    ops.push_back(suggestAll.json());
+
+    opTimer connected("mostConnected");
+    connected.repeat(cfg, [&](size_t) { delete[] g.mostConnected(10); });
+    ops.push_back(connected.json());
+
+    opTimer influential("mostInfluential");
+    influential.repeat(cfg, [&](size_t) { delete[] g.mostInfluential(10); });
+    ops.push_back(influential.json());
+
+    opTimer reaching("mostReaching");
+    reaching.repeat(cfg, [&](size_t) { delete[] g.mostReaching(10); });
+    ops.push_back(reaching.json());
+
+    // Edge changes (against the adjacency lists); every follow made here is undone by the unfollows
+    cerr << "users " << n << ": follow/unfollow" << endl;
+    // The first change after loading a snapshot also builds every adjacency list, so it is timed on its own
+    opTimer firstEdit("firstEdit");
+    firstEdit.time([&]() { if (g.follow(a[0], b[0])) g.unfollow(a[0], b[0]); });
+    ops.push_back(firstEdit.json());
+
+    vector<size_t> made;
+    benchConfig once = cfg;  // Each sampled pair at most once, so no call is a repeat of an earlier follow
+    once.reps = samples;
+    opTimer follow("follow");
+    follow.repeat(once, [&](size_t i) {
+        if (g.follow(a[i], b[(i + 1) % samples])) made.push_back(i);
+    });
+    opTimer unfollow("unfollow");
+    for (size_t k = 0; k < made.size(); k++) {
+        size_t i = made[k];
+        unfollow.time([&]() { g.unfollow(a[i], b[(i + 1) % samples]); });
+    }
+    ops.push_back(follow.json());
+    ops.push_back(unfollow.json());
+
+    // Live batches: each call follows 1000 sampled pairs, and the next undoes them, so the network stays the same size
+    cerr << "users " << n << ": liveApply" << endl;
+    {
+        liveGraph live(g);
+        const size_t batch = 1000;
+        opTimer liveApply("liveApply");
+        liveApply.repeat(cfg, [&](size_t i) {
+            vector<followEvent> events;
+            for (size_t j = 0; j < batch; j++) {
+                size_t s = (j + (i / 2) * batch) % samples;
+                events.push_back(followEvent(a[s], b[(s + 1) % samples], i % 2 == 0));
+            }
+            sink += live.apply(events);
+        });
+        ops.push_back(liveApply.json());
+    }
+
+    // Multi-producer ingestion, end to end: producer t stages follows from users t, t + p, ... to pseudo-random users,
+    // then compaction adds them on p threads; every round uses different targets, so its follows are new
+    cerr << "users " << n << ": ingest" << endl;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    for (unsigned p = 1, round = 0; ; p = min(2 * p, cores), round++) {
+        followIngest ingest(g, p);
+        uint64_t salt = cfg.seed + 7919 * (round + 1);
+        auto start = chrono::steady_clock::now();
+        vector<thread> pool;
+        for (unsigned t = 0; t < p; t++) {
+            pool.push_back(thread([&, t]() {
+                for (uint32_t u = t; u < n; u += p) ingest.follow(t, u, (uint32_t)(((uint64_t)u * 2654435761u + salt) % n));
+            }));
+        }
+        for (thread& th : pool) th.join();
+        uint64_t staged = ingest.staged();
+        auto staging = chrono::steady_clock::now();
+        sink += ingest.compact(p);
+        auto done = chrono::steady_clock::now();
+
+        double stageSecs = chrono::duration<double>(staging - start).count();
+        double compactSecs = chrono::duration<double>(done - staging).count();
+        ostringstream entry;
+        entry.setf(ios::fixed);
+        entry.precision(1);
+        entry << "{\"op\": \"ingest\", \"threads\": " << p << ", \"follows\": " << staged << ", \"followsPerSec\": "
+              << staged / (stageSecs + compactSecs) << ", \"stageNs\": " << stageSecs * 1e9 << ", \"compactNs\": " << compactSecs * 1e9 << "}";
+        ops.push_back(entry.str());
+        if (p == cores) break;
+    }
+
+    delete network;
+
+    cout << "    {\"users\": " << n << ", \"follows\": " << params.follows << ", \"peakRssKb\": " << peakRssKb() << ", \"ops\": [" << endl;
+    for (size_t i = 0; i < ops.size(); i++) cout << "      " << ops[i] << (i + 1 < ops.size() ? "," : "") << endl;
+    cout << "    ]}";
+    cout.flush();
+}
+
+int main(int argc, char** argv) {
+    benchConfig cfg;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string opt = argv[i], val = argv[i + 1];
+        if (opt == "-users") {
+            cfg.sizes.clear();
+            stringstream list(val);
+            string item;
+            while (getline(list, item, ',')) cfg.sizes.push_back((uint32_t)strtoul(item.c_str(), nullptr, 10));
+        } else if (opt == "-degree") cfg.degree = strtoull(val.c_str(), nullptr, 10);
+        else if (opt == "-model") {
+            cfg.modelName = val;
+            if (!parseGenModel(val, cfg.model)) {
+                cerr << "Unknown model " << val << " (use uniform, ba, rmat or chunglu)" << endl;
+                return 1;
+            }
+        } else if (opt == "-seed") cfg.seed = strtoull(val.c_str(), nullptr, 10);
+        else if (opt == "-reps") cfg.reps = strtoull(val.c_str(), nullptr, 10);
+        else if (opt == "-budget") cfg.budget = atof(val.c_str());
+        else if (opt == "-label") cfg.label = val;
+        else if (opt == "-snapshot") cfg.snapshotPath = val;
+        else {
+            cerr << "Unknown option " << opt << endl;
+            return 1;
+        }
+    }
+
+    cout << "{\"label\": " << jsonString(cfg.label) << ", \"model\": " << jsonString(cfg.modelName) << ", \"degree\": " << cfg.degree
+         << ", \"seed\": " << cfg.seed << ", \"results\": [" << endl;
+    bool first = true;
+    for (uint32_t n : cfg.sizes) {
+        if (!n) continue;
+        if (!first) cout << "," << endl;
+        cout.flush();
+
+        pid_t child = fork();  // A fresh process per size keeps the peak RSS numbers separate
+        if (child == 0) {
+            benchSize(cfg, n);
+            _exit(0);
+        }
+        int status = 0;
+        if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            cerr << "users " << n << ": run failed" << endl;
+            cout << "    {\"users\": " << n << ", \"error\": \"run failed\"}";
+        }
+        first = false;
+    }
+    cout << endl << "]}" << endl;
+    return 0;
+}
@@ -0,0 +1,131 @@
+#ifndef _BETWEENNESS_H_
+#define _BETWEENNESS_H_
+
+/*
+Betweenness:
+-Betweenness centrality over a CSR snapshot (see csr.h) with Brandes' algorithm:
+    one BFS per source counts shortest paths, then a backwards pass adds up each user's share of them
+-High betweenness = the user sits on many shortest follow paths, i.e. a bridge between groups
+-Predecessors are found by scanning the followers row (dist[v] == dist[w] - 1), so no per-source lists are built
+-Exact mode uses every user as a source; sampled mode uses k random pivot sources and scales by n / k
+-Sources are handed out to worker threads through an atomic counter; each thread has its own
+    BFS/dependency buffers and its own score array, and the arrays are added together at the end
+*/
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include "csr.h"
+using namespace std;
+
+// Add scale * (dependency of every vertex on each source) to bc, splitting the sources over threads
+// threads = 0 picks one thread per core
+void brandes(const csrGraph& g, const vector<uint32_t>& sources, double scale, vector<double>& bc, unsigned threads) {
+    uint32_t n = g.numNodes;
+    bc.assign(n, 0.0);
+    if (!n || sources.empty()) return;
+
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)min<size_t>(threads, sources.size());
+
+    atomic<size_t> nextSource(0);
+    vector<vector<double>> partial(threads);
+
+    auto worker = [&](unsigned t) {
+        vector<double>& score = partial[t];
+        score.assign(n, 0.0);
+        vector<uint32_t> dist(n, UINT32_MAX);  // BFS distance from the source
+        vector<double> sigma(n, 0.0);          // Number of shortest paths from the source
+        vector<double> delta(n, 0.0);          // Dependency of the source on each vertex
+        vector<uint32_t> order;                // Vertices in BFS order (doubles as the queue)
+        order.reserve(n);
+
+        for (size_t i = nextSource++; i < sources.size(); i = nextSource++) {
+            uint32_t s = sources[i];
+            order.clear();
+            order.push_back(s);
+            dist[s] = 0;
+            sigma[s] = 1;
+
+            // Count shortest paths outward from s
+            for (size_t head = 0; head < order.size(); head++) {
+                uint32_t v = order[head];
+                for (const uint32_t* w = g.outBegin(v); w != g.outEnd(v); w++) {
+                    if (dist[*w] == UINT32_MAX) {
+                        dist[*w] = dist[v] + 1;
+                        order.push_back(*w);
+                    }
+                    if (dist[*w] == dist[v] + 1) sigma[*w] += sigma[v];
+                }
+            }
+
+            // Walk back from the farthest vertices, passing each one's dependency to its predecessors
+            for (size_t j = order.size(); j-- > 1; ) {
+                uint32_t w = order[j];
+                double share = (1.0 + delta[w]) / sigma[w];
+                for (const uint32_t* v = g.inBegin(w); v != g.inEnd(w); v++) {
+                    if (dist[*v] + 1 == dist[w]) delta[*v] += sigma[*v] * share;
+                }
+                score[w] += scale * delta[w];
+            }
+
+            // Reset only what this source touched
+            for (uint32_t v : order) {
+                dist[v] = UINT32_MAX;
+                sigma[v] = 0;
+                delta[v] = 0;
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.push_back(thread(worker, t));
+    worker(0);
+    for (thread& th : pool) th.join();
+
+    for (unsigned t = 0; t < threads; t++) {
+        for (uint32_t v = 0; v < n; v++) bc[v] += partial[t][v];
+    }
+}
+
+// Number of pivots needed so that, with probability at least 1 - failProb, every user's normalized betweenness
+// (betweenness / ((n - 1)(n - 2))) is within epsilon of the exact value (Hoeffding bound plus a union bound over the n users)
+uint32_t betweennessPivots(uint32_t n, double epsilon, double failProb) {
+    if (n < 3) return n;
+    double k = ceil((log(2.0 * n) + log(1.0 / failProb)) / (2.0 * epsilon * epsilon));
+    return k >= n ? n : (uint32_t)k;
+}
+
+// Exact betweenness: every vertex is a source
+void betweennessExact(const csrGraph& g, vector<double>& bc, unsigned threads) {
+    vector<uint32_t> sources(g.numNodes);
+    for (uint32_t v = 0; v < g.numNodes; v++) sources[v] = v;
+    brandes(g, sources, 1.0, bc, threads);
+}
+
+// Approximate betweenness from k pivot sources drawn without replacement (exact when k >= n)
+void betweennessSampled(const csrGraph& g, vector<double>& bc, uint32_t k, uint64_t seed, unsigned threads) {
+    uint32_t n = g.numNodes;
+    if (k >= n) {
+        betweennessExact(g, bc, threads);
+        return;
+    }
+
+    // Partial Fisher-Yates shuffle picks k distinct sources
+    vector<uint32_t> sources(n);
+    for (uint32_t v = 0; v < n; v++) sources[v] = v;
+    mt19937_64 gen(seed);
+    for (uint32_t i = 0; i < k; i++) {
+        uniform_int_distribution<uint32_t> pick(i, n - 1);
+        swap(sources[i], sources[pick(gen)]);
+    }
+    sources.resize(k);
+
+    brandes(g, sources, (double)n / k, bc, threads);
+}
+
+#endif
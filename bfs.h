@@ -0,0 +1,158 @@
+#ifndef _BFS_H_
+#define _BFS_H_
+
+/*
+BFS:
+-Shortest follow paths over a CSR snapshot (see csr.h), or any graph with the same row accessors (see pagedCsr.h)
+-Bidirectional: grows a forward search over following and a backward search over followers,
+    always expanding whichever frontier is smaller, until the two meet
+-Visited marks are epoch stamps: a vertex counts as seen only if its stamp equals the current query's epoch,
+    so starting a new query is just epoch++ instead of clearing arrays
+-All arrays are sized once per snapshot and reused, so a query allocates nothing
+*/
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "csr.h"
+using namespace std;
+
+class bfsEngine {
+private:
+    uint32_t epoch;                // Stamp of the current query
+    vector<uint32_t> seenF;        // Epoch at which each vertex was reached by the forward search
+    vector<uint32_t> seenB;        // Epoch at which each vertex was reached by the backward search
+    vector<uint32_t> distF;        // Distance from the source (valid when seenF matches epoch)
+    vector<uint32_t> distB;        // Distance to the target (valid when seenB matches epoch)
+    vector<uint32_t> parF;         // Forward parent of each vertex, for path reconstruction
+    vector<uint32_t> parB;         // Backward parent (the next hop towards the target)
+    vector<uint32_t> queueF;       // Forward queue (each vertex enters at most once per query)
+    vector<uint32_t> queueB;       // Backward queue
+
+    void prepare(uint32_t n);      // Size the arrays for n vertices and start a new epoch
+    template <typename G>
+    uint32_t search(const G& g, uint32_t s, uint32_t t, uint32_t* meetF, uint32_t* meetB);  // Run the search, returning the distance and the edge where the two sides met
+
+public:
+    static const uint32_t NONE = UINT32_MAX;  // Returned when the target cannot be reached
+
+    bfsEngine();
+
+    template <typename G>
+    uint32_t distance(const G& g, uint32_t s, uint32_t t);                    // Number of follow hops from s to t
+    template <typename G>
+    uint32_t path(const G& g, uint32_t s, uint32_t t, vector<uint32_t>& out); // Same, also filling out with s ... t
+};
+
+const uint32_t bfsEngine::NONE;
+
+bfsEngine::bfsEngine() : epoch(0) {}
+
+void bfsEngine::prepare(uint32_t n) {
+    if (seenF.size() != n) {  // New snapshot size: reallocate once
+        seenF.assign(n, 0);
+        seenB.assign(n, 0);
+        distF.resize(n);
+        distB.resize(n);
+        parF.resize(n);
+        parB.resize(n);
+        queueF.resize(n);
+        queueB.resize(n);
+        epoch = 0;
+    }
+    if (++epoch == 0) {  // The stamp wrapped around, so old stamps could look current again
+        fill(seenF.begin(), seenF.end(), 0);
+        fill(seenB.begin(), seenB.end(), 0);
+        epoch = 1;
+    }
+}
+
+template <typename G>
+uint32_t bfsEngine::search(const G& g, uint32_t s, uint32_t t, uint32_t* meetF, uint32_t* meetB) {
+    prepare(g.numNodes);
+    *meetF = *meetB = NONE;
+    if (s == t) return 0;
+
+    size_t headF = 0, tailF = 0, headB = 0, tailB = 0;
+    seenF[s] = epoch; distF[s] = 0; parF[s] = NONE; queueF[tailF++] = s;
+    seenB[t] = epoch; distB[t] = 0; parB[t] = NONE; queueB[tailB++] = t;
+
+    uint64_t workF = g.outDeg(s), workB = g.inDeg(t);  // Edges the next level of each side will scan
+    uint32_t best = NONE;
+
+    while (headF < tailF && headB < tailB) {
+        bool forward = workF <= workB;  // Expand the cheaper side by one whole level
+        uint64_t work = 0;
+
+        if (forward) {
+            size_t levelEnd = tailF;
+            for (; headF < levelEnd; headF++) {
+                uint32_t u = queueF[headF];
+                for (const uint32_t* v = g.outBegin(u), *end = g.outEnd(u); v != end; v++) {
+                    if (seenB[*v] == epoch && distF[u] + 1 + distB[*v] < best) {  // The searches meet on the edge u -> v
+                        best = distF[u] + 1 + distB[*v];
+                        *meetF = u;
+                        *meetB = *v;
+                    }
+                    if (seenF[*v] == epoch) continue;
+                    seenF[*v] = epoch;
+                    distF[*v] = distF[u] + 1;
+                    parF[*v] = u;
+                    queueF[tailF++] = *v;
+                    work += g.outDeg(*v);
+                }
+            }
+            workF = work;
+        }
+        else {
+            size_t levelEnd = tailB;
+            for (; headB < levelEnd; headB++) {
+                uint32_t u = queueB[headB];
+                for (const uint32_t* v = g.inBegin(u), *end = g.inEnd(u); v != end; v++) {
+                    if (seenF[*v] == epoch && distF[*v] + 1 + distB[u] < best) {  // The searches meet on the edge v -> u
+                        best = distF[*v] + 1 + distB[u];
+                        *meetF = *v;
+                        *meetB = u;
+                    }
+                    if (seenB[*v] == epoch) continue;
+                    seenB[*v] = epoch;
+                    distB[*v] = distB[u] + 1;
+                    parB[*v] = u;
+                    queueB[tailB++] = *v;
+                    work += g.inDeg(*v);
+                }
+            }
+            workB = work;
+        }
+
+        if (best != NONE) return best;  // Every meeting in this level was checked, so best is the shortest
+    }
+
+    return NONE;  // One side ran out of vertices without meeting the other
+}
+
+template <typename G>
+uint32_t bfsEngine::distance(const G& g, uint32_t s, uint32_t t) {
+    uint32_t meetF, meetB;
+    return search(g, s, t, &meetF, &meetB);
+}
+
+template <typename G>
+uint32_t bfsEngine::path(const G& g, uint32_t s, uint32_t t, vector<uint32_t>& out) {
+    uint32_t meetF, meetB;
+    uint32_t d = search(g, s, t, &meetF, &meetB);
+    out.clear();
+    if (d == NONE) return d;
+    if (d == 0) {
+        out.push_back(s);
+        return d;
+    }
+
+    // Walk back from the forward end of the meeting edge to the source, then on from its backward end to the target
+    for (uint32_t v = meetF; v != NONE; v = parF[v]) out.push_back(v);
+    reverse(out.begin(), out.end());
+    for (uint32_t v = meetB; v != NONE; v = parB[v]) out.push_back(v);
+    return d;
+}
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef _BTREE_H_
+#define _BTREE_H_
+
+/*
+B+-tree:
+-Cache-friendly alternative to the AVL tree for the graph's vertex index (see vertexIndex.h)
+-Every node holds up to 16 keys, so a lookup touches about log16(n) nodes instead of log2(n)
+-Each key is stored as an 8-byte prefix of the username (packed big-endian, so comparing prefixes as integers
+    matches string order) next to the full key; searches scan the packed prefixes and only look at
+    whole usernames when two prefixes tie
+-Users live in the leaves, which are chained left to right for in-order walks
+-Inner nodes hold copies of separator usernames: kids[i] holds keys below seps[i], kids[i + 1] holds keys at or above it
+    (copies rather than user pointers, so removing and freeing a user never leaves a dangling separator)
+-Insert splits full nodes on the way back up; remove just takes the key out of its leaf
+    (separators stay valid bounds, so lookups are unaffected by underfull leaves)
+-Bulk load fills the leaves left to right and builds each level above in O(n)
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "adjList.h"
+using namespace std;
+
+const int bOrder = 16;  // Keys per node
+
+struct bNode {  // Fields shared by leaves and inner nodes
+    bool leaf;  // Whether this is a leaf
+    int count;  // Number of keys in use
+    uint64_t prefix[bOrder];  // Packed username prefixes of the keys
+
+    bNode(bool isLeaf) : leaf(isLeaf), count(0) {}
+};
+
+struct bLeaf : bNode {  // Leaf: keys are the users themselves
+    user* keys[bOrder];  // Users, in username order
+    bLeaf* next;  // Leaf to the right (nullptr for the last leaf)
+
+    bLeaf() : bNode(true), next(nullptr) {}
+};
+
+struct bInner : bNode {  // Inner node: keys separate the children
+    string seps[bOrder];  // Separator usernames
+    bNode* kids[bOrder + 1];  // Children (count + 1 in use)
+
+    bInner() : bNode(false) {}
+};
+
+class bTree {
+private:
+    bNode* root;  // Root of the tree (nullptr when empty)
+    int size;  // Number of users stored
+
+    static const int maxDepth = 32;  // Deeper than any tree that fits in memory
+
+    static uint64_t packPrefix(const string& k);  // First 8 bytes of a username as a big-endian integer
+    static int compare(uint64_t p, const string& k, const bNode* node, int i);  // Compare a key with a node's i-th key
+    static int upperBound(const bNode* node, uint64_t p, const string& k);  // Number of keys in the node at or below k
+    void freeRec(bNode* node);  // Recursive method to delete a subtree
+
+public:
+    bTree();  // Constructor
+    bTree(user** arr, int len, bool sorted = false);  // Bulk-load constructor
+    ~bTree();  // Destructor
+
+    user** getArr(int len) const;  // Method to get an array of all users in username order
+    int bulkLoad(user** arr, int len, bool sorted = false);  // Method to build an empty tree from a batch of users
+    void clear();  // Method to empty the tree
+    bool insert(user* k);  // Method to insert a user into the tree
+    bool remove(const string& k);  // Method to remove a user by username
+    user* retrieve(const string& k) const;  // Method to retrieve a user by username
+};
+
+const int bTree::maxDepth;
+
+bTree::bTree() : root(nullptr), size(0) {}
+
+bTree::bTree(user** arr, int len, bool sorted) : root(nullptr), size(0) {
+    bulkLoad(arr, len, sorted);
+}
+
+bTree::~bTree() {
+    freeRec(root);
+}
+
+void bTree::clear() {
+    freeRec(root);
+    root = nullptr;
+    size = 0;
+}
+
+void bTree::freeRec(bNode* node) {
+    if (!node) return;
+    if (node->leaf) {
+        delete (bLeaf*)node;
+        return;
+    }
+    bInner* inner = (bInner*)node;
+    for (int i = 0; i <= inner->count; i++) freeRec(inner->kids[i]);
+    delete inner;
+}
+
+uint64_t bTree::packPrefix(const string& k) {
+    uint64_t p = 0;
+    for (size_t i = 0; i < 8; i++) {
+        p <<= 8;
+        if (i < k.size()) p |= (unsigned char)k[i];  // Short names are padded with zero bytes, which sort first
+    }
+    return p;
+}
+
+int bTree::compare(uint64_t p, const string& k, const bNode* node, int i) {
+    if (p != node->prefix[i]) return p < node->prefix[i] ? -1 : 1;  // Decided by the prefixes alone
+    const string& key = node->leaf ? ((const bLeaf*)node)->keys[i]->username : ((const bInner*)node)->seps[i];
+    return k.compare(key);  // Tie: compare the whole usernames
+}
+
+int bTree::upperBound(const bNode* node, uint64_t p, const string& k) {
+    int i = 0;
+    while (i < node->count && compare(p, k, node, i) >= 0) i++;  // Linear scan of a packed prefix array
+    return i;
+}
+
+user* bTree::retrieve(const string& k) const {
+    if (!root) return nullptr;
+    uint64_t p = packPrefix(k);
+
+    const bNode* node = root;
+    while (!node->leaf) node = ((const bInner*)node)->kids[upperBound(node, p, k)];  // Walk down to the leaf that would hold k
+
+    int i = upperBound(node, p, k);  // The match, if any, is the last key at or below k
+    if (i > 0 && compare(p, k, node, i - 1) == 0) return ((const bLeaf*)node)->keys[i - 1];
+    return nullptr;
+}
+
+bool bTree::insert(user* k) {
+    uint64_t p = packPrefix(k->username);
+    if (!root) {  // First user: a single leaf
+        bLeaf* leaf = new bLeaf();
+        leaf->prefix[0] = p;
+        leaf->keys[0] = k;
+        leaf->count = 1;
+        root = leaf;
+        size = 1;
+        return true;
+    }
+
+    // Walk down, remembering each inner node and the child taken
+    bInner* path[maxDepth];
+    int slot[maxDepth];
+    int depth = 0;
+    bNode* node = root;
+    while (!node->leaf) {
+        int i = upperBound(node, p, k->username);
+        path[depth] = (bInner*)node;
+        slot[depth++] = i;
+        node = ((bInner*)node)->kids[i];
+    }
+
+    bLeaf* leaf = (bLeaf*)node;
+    int pos = upperBound(leaf, p, k->username);
+    if (pos > 0 && compare(p, k->username, leaf, pos - 1) == 0) return false;  // Username already taken
+    size++;
+
+    if (leaf->count < bOrder) {  // Room in the leaf: shift and insert
+        for (int j = leaf->count; j > pos; j--) {
+            leaf->prefix[j] = leaf->prefix[j - 1];
+            leaf->keys[j] = leaf->keys[j - 1];
+        }
+        leaf->prefix[pos] = p;
+        leaf->keys[pos] = k;
+        leaf->count++;
+        return true;
+    }
+
+    // Full leaf: lay out all bOrder + 1 keys, keep the lower half and move the upper half to a new right leaf
+    uint64_t allP[bOrder + 1];
+    user* allK[bOrder + 1];
+    for (int j = 0, from = 0; j <= bOrder; j++) {
+        if (j == pos) {
+            allP[j] = p;
+            allK[j] = k;
+        }
+        else {
+            allP[j] = leaf->prefix[from];
+            allK[j] = leaf->keys[from++];
+        }
+    }
+    bLeaf* right = new bLeaf();
+    int half = (bOrder + 1) / 2;
+    leaf->count = half;
+    right->count = bOrder + 1 - half;
+    for (int j = 0; j < half; j++) {
+        leaf->prefix[j] = allP[j];
+        leaf->keys[j] = allK[j];
+    }
+    for (int j = 0; j < right->count; j++) {
+        right->prefix[j] = allP[half + j];
+        right->keys[j] = allK[half + j];
+    }
+    right->next = leaf->next;
+    leaf->next = right;
+
+    // Push the separator (first key of the new node) up, splitting full parents as needed
+    uint64_t sepP = right->prefix[0];
+    string sepK = right->keys[0]->username;
+    bNode* newKid = right;
+    while (depth > 0) {
+        bInner* parent = path[--depth];
+        int i = slot[depth];
+
+        if (parent->count < bOrder) {  // Room in the parent: shift and insert
+            for (int j = parent->count; j > i; j--) {
+                parent->prefix[j] = parent->prefix[j - 1];
+                parent->seps[j].swap(parent->seps[j - 1]);
+                parent->kids[j + 1] = parent->kids[j];
+            }
+            parent->prefix[i] = sepP;
+            parent->seps[i].swap(sepK);
+            parent->kids[i + 1] = newKid;
+            parent->count++;
+            return true;
+        }
+
+        // Full parent: lay out bOrder + 1 keys and bOrder + 2 children, then split around the middle key
+        uint64_t pP[bOrder + 1];
+        string pK[bOrder + 1];
+        bNode* pKids[bOrder + 2];
+        for (int j = 0, from = 0; j <= bOrder; j++) {
+            if (j == i) {
+                pP[j] = sepP;
+                pK[j].swap(sepK);
+            }
+            else {
+                pP[j] = parent->prefix[from];
+                pK[j].swap(parent->seps[from++]);
+            }
+        }
+        for (int j = 0, from = 0; j <= bOrder + 1; j++) {
+            if (j == i + 1) pKids[j] = newKid;
+            else pKids[j] = parent->kids[from++];
+        }
+
+        bInner* sibling = new bInner();
+        int mid = (bOrder + 1) / 2;  // This key moves up; it is not kept in either half
+        parent->count = mid;
+        sibling->count = bOrder - mid;
+        for (int j = 0; j < mid; j++) {
+            parent->prefix[j] = pP[j];
+            parent->seps[j].swap(pK[j]);
+            parent->kids[j] = pKids[j];
+        }
+        parent->kids[mid] = pKids[mid];
+        for (int j = 0; j < sibling->count; j++) {
+            sibling->prefix[j] = pP[mid + 1 + j];
+            sibling->seps[j].swap(pK[mid + 1 + j]);
+            sibling->kids[j] = pKids[mid + 1 + j];
+        }
+        sibling->kids[sibling->count] = pKids[bOrder + 1];
+
+        sepP = pP[mid];
+        sepK.swap(pK[mid]);
+        newKid = sibling;
+    }
+
+    // The root itself split: grow the tree by one level
+    bInner* newRoot = new bInner();
+    newRoot->count = 1;
+    newRoot->prefix[0] = sepP;
+    newRoot->seps[0].swap(sepK);
+    newRoot->kids[0] = root;
+    newRoot->kids[1] = newKid;
+    root = newRoot;
+    return true;
+}
+
+bool bTree::remove(const string& k) {
+    if (!root) return false;
+    uint64_t p = packPrefix(k);
+
+    bNode* node = root;
+    while (!node->leaf) node = ((bInner*)node)->kids[upperBound(node, p, k)];
+
+    int i = upperBound(node, p, k) - 1;
+    if (i < 0 || compare(p, k, node, i) != 0) return false;  // Not in the tree
+
+    bLeaf* leaf = (bLeaf*)node;
+    for (int j = i; j + 1 < leaf->count; j++) {  // Close the gap in the leaf
+        leaf->prefix[j] = leaf->prefix[j + 1];
+        leaf->keys[j] = leaf->keys[j + 1];
+    }
+    leaf->count--;
+    size--;
+    return true;
+}
+
+int bTree::bulkLoad(user** arr, int len, bool sorted) {
+    if (root) return 0;  // Only an empty tree can be bulk-loaded
+
+    // Sort a copy of the batch by username unless it already is, and drop repeated usernames (the first one wins)
+    vector<user*> batch(arr, arr + len);
+    if (!sorted) stable_sort(batch.begin(), batch.end(), [](user* a, user* b) { return a->username < b->username; });
+    batch.erase(unique(batch.begin(), batch.end(), [](user* a, user* b) { return a->username == b->username; }), batch.end());
+    if (batch.empty()) return 0;
+
+    // Fill the leaves left to right
+    vector<bNode*> level;
+    vector<user*> firstKey;  // Smallest user under each node of the level
+    bLeaf* prev = nullptr;
+    for (size_t i = 0; i < batch.size(); i += bOrder) {
+        bLeaf* leaf = new bLeaf();
+        for (size_t j = i; j < batch.size() && j < i + bOrder; j++) {
+            leaf->prefix[leaf->count] = packPrefix(batch[j]->username);
+            leaf->keys[leaf->count++] = batch[j];
+        }
+        if (prev) prev->next = leaf;
+        prev = leaf;
+        level.push_back(leaf);
+        firstKey.push_back(batch[i]);
+    }
+
+    // Build each inner level from the one below until a single root remains
+    while (level.size() > 1) {
+        vector<bNode*> up;
+        vector<user*> upFirst;
+        size_t groups = (level.size() + bOrder) / (bOrder + 1);  // Inner nodes needed for this level
+        for (size_t g = 0, i = 0; g < groups; g++) {
+            size_t end = i + (level.size() - i) / (groups - g);  // Spread the children evenly so no node ends up with a single child
+            bInner* inner = new bInner();
+            inner->kids[0] = level[i];
+            for (size_t j = i + 1; j < end; j++) {
+                inner->prefix[inner->count] = packPrefix(firstKey[j]->username);
+                inner->seps[inner->count++] = firstKey[j]->username;
+                inner->kids[inner->count] = level[j];
+            }
+            up.push_back(inner);
+            upFirst.push_back(firstKey[i]);
+            i = end;
+        }
+        level.swap(up);
+        firstKey.swap(upFirst);
+    }
+
+    root = level[0];
+    size = (int)batch.size();
+    return size;
+}
+
+user** bTree::getArr(int len) const {
+    user** arr = new user*[len];
+    if (!root) return arr;
+
+    const bNode* node = root;
+    while (!node->leaf) node = ((const bInner*)node)->kids[0];  // Leftmost leaf
+
+    int i = 0;
+    for (const bLeaf* leaf = (const bLeaf*)node; leaf; leaf = leaf->next) {  // Follow the leaf chain
+        for (int j = 0; j < leaf->count && i < len; j++) arr[i++] = leaf->keys[j];
+    }
+    return arr;
+}
+
+#endif
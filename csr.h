@@ -0,0 +1,138 @@
+#ifndef _CSR_H_
+#define _CSR_H_
+
+/*
+CSR:
+-Frozen (read-only) compressed-sparse-row snapshot of the follow graph
+-Users are numbered with dense uint32 IDs (their index in the graph's users array)
+-Two directions are stored:
+    -outOff/outAdj: who each user is following
+    -inOff/inAdj: who each user is followed by
+-The neighbours of v are adj[off[v]] ... adj[off[v + 1] - 1], sorted by ID
+-Everything lives in a few contiguous arrays, so analytics never chase aNode pointers
+-Built by graph::freeze() (or csrFromKeys, from a sorted edge list) and thrown away whenever the graph changes
+-pagedCsr (see pagedCsr.h) cuts a snapshot into pages that successive versions can share, for liveGraph
+-The arrays are either owned by the snapshot (freeze) or borrowed from a memory-mapped snapshot file
+    (see snapshot.h); a borrowed snapshot is never written to and frees nothing
+*/
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+using namespace std;
+
+struct csrGraph {
+    uint32_t numNodes;             // Number of users (IDs run from 0 to numNodes - 1)
+    uint64_t numEdges;             // Number of follow edges
+
+    uint64_t* outOff;              // Offsets into outAdj (numNodes + 1 entries)
+    uint32_t* outAdj;              // IDs of the users each user is following
+    uint64_t* inOff;               // Offsets into inAdj (numNodes + 1 entries)
+    uint32_t* inAdj;               // IDs of each user's followers
+
+    csrGraph(uint32_t n, uint64_t m);  // Owned arrays, offsets zeroed (filled in by the builder)
+    csrGraph(uint32_t n, uint64_t m, const uint64_t* oOff, const uint32_t* oAdj, const uint64_t* iOff, const uint32_t* iAdj);  // Borrowed arrays
+    ~csrGraph();
+
+    const uint32_t* outBegin(uint32_t v) const { return outAdj + outOff[v]; }          // First user v is following
+    const uint32_t* outEnd(uint32_t v) const { return outAdj + outOff[v + 1]; }        // One past the last user v is following
+    uint32_t outDeg(uint32_t v) const { return (uint32_t)(outOff[v + 1] - outOff[v]); } // Number of users v is following
+
+    const uint32_t* inBegin(uint32_t v) const { return inAdj + inOff[v]; }             // First follower of v
+    const uint32_t* inEnd(uint32_t v) const { return inAdj + inOff[v + 1]; }           // One past the last follower of v
+    uint32_t inDeg(uint32_t v) const { return (uint32_t)(inOff[v + 1] - inOff[v]); }   // Number of followers of v
+
+    bool isFollowing(uint32_t u, uint32_t v) const;  // Whether u follows v (binary search of u's sorted row)
+
+private:
+    bool owned;                    // Whether the destructor frees the arrays
+
+    csrGraph(const csrGraph&);     // Snapshots are shared by pointer, never copied
+    csrGraph& operator=(const csrGraph&);
+};
+
+csrGraph::csrGraph(uint32_t n, uint64_t m) : numNodes(n), numEdges(m), owned(true) {
+    outOff = new uint64_t[n + 1]();
+    outAdj = new uint32_t[m];
+    inOff = new uint64_t[n + 1]();
+    inAdj = new uint32_t[m];
+}
+
+// The borrowed arrays are only ever read; the casts just let both kinds of snapshot share one set of members
+csrGraph::csrGraph(uint32_t n, uint64_t m, const uint64_t* oOff, const uint32_t* oAdj, const uint64_t* iOff, const uint32_t* iAdj)
+    : numNodes(n), numEdges(m), outOff(const_cast<uint64_t*>(oOff)), outAdj(const_cast<uint32_t*>(oAdj)),
+      inOff(const_cast<uint64_t*>(iOff)), inAdj(const_cast<uint32_t*>(iAdj)), owned(false) {}
+
+csrGraph::~csrGraph() {
+    if (!owned) return;
+    delete[] outOff;
+    delete[] outAdj;
+    delete[] inOff;
+    delete[] inAdj;
+}
+
+bool csrGraph::isFollowing(uint32_t u, uint32_t v) const {
+    const uint32_t* lo = outBegin(u);
+    const uint32_t* hi = outEnd(u);
+    while (lo < hi) {  // Rows are sorted, so a binary search finds v in O(log degree)
+        const uint32_t* mid = lo + (hi - lo) / 2;
+        if (*mid < v) lo = mid + 1;
+        else if (*mid > v) hi = mid;
+        else return true;
+    }
+    return false;
+}
+
+// Build a snapshot straight from sorted, deduped edges packed as (follower << 32) | followed
+csrGraph* csrFromKeys(uint32_t n, const vector<uint64_t>& keys) {
+    csrGraph* g = new csrGraph(n, keys.size());
+    for (uint64_t k : keys) {
+        g->outOff[(k >> 32) + 1]++;
+        g->inOff[(uint32_t)k + 1]++;
+    }
+    for (uint32_t v = 0; v < n; v++) {
+        g->outOff[v + 1] += g->outOff[v];
+        g->inOff[v + 1] += g->inOff[v];
+    }
+
+    // The keys are already in row order; scattering them by followed ID leaves the follower rows sorted too
+    vector<uint64_t> fill(g->inOff, g->inOff + n);
+    for (size_t i = 0; i < keys.size(); i++) {
+        g->outAdj[i] = (uint32_t)keys[i];
+        g->inAdj[fill[(uint32_t)keys[i]]++] = (uint32_t)(keys[i] >> 32);
+    }
+    return g;
+}
+
+// Return the IDs of the k highest scores, best first (ties go to the lower ID)
+// A bounded min-heap keeps this at O(n log k) instead of sorting every user
+template <typename T>
+vector<uint32_t> topIds(const T* score, uint32_t n, int k) {
+    if (k > (int)n) k = n;
+    if (k <= 0) return vector<uint32_t>();
+
+    // Ordering by "stronger" leaves the weakest of the current best k at the top of the heap
+    auto stronger = [](const pair<T, uint32_t>& a, const pair<T, uint32_t>& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    priority_queue<pair<T, uint32_t>, vector<pair<T, uint32_t>>, decltype(stronger)> pq(stronger);
+
+    for (uint32_t v = 0; v < n; v++) {
+        if ((int)pq.size() < k) pq.push(make_pair(score[v], v));
+        else if (stronger(make_pair(score[v], v), pq.top())) {  // Beats the weakest of the current best k
+            pq.pop();
+            pq.push(make_pair(score[v], v));
+        }
+    }
+
+    vector<uint32_t> ids(pq.size());
+    for (int i = (int)ids.size() - 1; i >= 0; i--) {  // Pop weakest first, filling from the back
+        ids[i] = pq.top().second;
+        pq.pop();
+    }
+    return ids;
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef _CSVLOADER_H_
+#define _CSVLOADER_H_
+
+/*
+CSV loader:
+-Reads user_data.csv (username,firstname,lastname per line) in one pass with no per-line copies
+-forEachLine and chunkLines are shared with the edge-file loader (graph::loadEdges)
+-The file is memory-mapped (read into one buffer if mapping fails) and split in place:
+    -each field is a (pointer, length) view into the mapping, so nothing is copied until the user is made
+    -line and field ends are found with memchr, which the C library scans a word (or vector register) at a time
+-Large files are cut into one chunk per thread at line boundaries; each thread splits its chunk on its own,
+    and the chunks are joined in file order, so row numbers (and so user IDs) match a sequential read
+-Blank lines are skipped, a trailing '\r' is dropped, missing fields are empty and extra fields are ignored
+-The row views are only valid while the mappedFile is open
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+struct csvField {  // View of one field inside the file
+    const char* ptr;               // First character
+    uint32_t len;                  // Number of characters
+
+    csvField() : ptr(nullptr), len(0) {}
+    string str() const { return string(ptr, len); }  // Copy the field out
+};
+
+struct csvRow {  // One user's line
+    csvField username;
+    csvField firstname;
+    csvField lastname;
+};
+
+class mappedFile {  // Read-only view of a whole file
+private:
+    const char* base;              // Start of the file's bytes
+    size_t len;                    // Size of the file
+    bool mapped;                   // Whether base is an mmap (true) or a copy in buf (false)
+    vector<char> buf;              // Fallback copy when the file cannot be mapped
+
+    mappedFile(const mappedFile&);  // The mapping is owned, so it cannot be copied
+    mappedFile& operator=(const mappedFile&);
+
+public:
+    mappedFile() : base(nullptr), len(0), mapped(false) {}
+    ~mappedFile() { close(); }
+
+    bool open(const string& path);  // Map the file; false if it cannot be opened
+    void close();                   // Unmap the file (invalidates every row view)
+    const char* data() const { return base; }
+    size_t size() const { return len; }
+};
+
+bool mappedFile::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return false;
+    }
+    len = (size_t)st.st_size;
+
+    if (len) {
+        void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, len, MADV_SEQUENTIAL);  // Read ahead aggressively; every byte is scanned once, front to back
+            base = static_cast<const char*>(p);
+            mapped = true;
+        } else {  // Not mappable (e.g. a pipe): read it into memory instead
+            buf.resize(len);
+            size_t got = 0;
+            ssize_t n;
+            while (got < len && (n = read(fd, buf.data() + got, len - got)) > 0) got += (size_t)n;
+            len = got;
+            base = buf.data();
+        }
+    }
+    ::close(fd);  // The mapping stays valid without the descriptor
+    return true;
+}
+
+void mappedFile::close() {
+    if (mapped) munmap(const_cast<char*>(base), len);
+    base = nullptr;
+    len = 0;
+    mapped = false;
+    buf.clear();
+}
+
+// Call onLine(first, last) for every non-blank line in [begin, end), with the newline and any trailing '\r' cut off
+template <typename F>
+void forEachLine(const char* begin, const char* end, F onLine) {
+    while (begin < end) {
+        const char* eol = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        if (!eol) eol = end;  // Last line without a newline
+        const char* stop = (eol > begin && eol[-1] == '\r') ? eol - 1 : eol;
+        if (stop > begin) onLine(begin, stop);  // Skip blank lines
+        begin = eol + 1;
+    }
+}
+
+// Cut a file into one chunk per thread (0 = one per core, but no chunk under 4MB), each ending just past a newline
+// Returns the chunk bounds: chunk t is [cuts[t], cuts[t + 1])
+vector<const char*> chunkLines(const mappedFile& file, unsigned threads = 0) {
+    const size_t minChunk = 1 << 22;
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<size_t>(1, min<size_t>(threads, file.size() / minChunk));
+
+    // Cut the file into equal chunks, then move every cut forward to just past the next newline
+    vector<const char*> cuts(threads + 1, end);
+    cuts[0] = begin;
+    for (unsigned t = 1; t < threads; t++) {
+        const char* guess = max(begin + file.size() / threads * t, cuts[t - 1]);
+        const char* nl = static_cast<const char*>(memchr(guess, '\n', end - guess));
+        cuts[t] = nl ? nl + 1 : end;
+    }
+    return cuts;
+}
+
+// Split the lines in [begin, end) into rows, appending them to rows
+void splitRows(const char* begin, const char* end, vector<csvRow>& rows) {
+    forEachLine(begin, end, [&](const char* first, const char* last) {
+        csvRow row;
+        csvField* fields[3] = {&row.username, &row.firstname, &row.lastname};
+        const char* p = first;
+        for (int f = 0; f < 3 && p <= last; f++) {
+            const char* comma = static_cast<const char*>(memchr(p, ',', last - p));
+            if (!comma) comma = last;
+            fields[f]->ptr = p;
+            fields[f]->len = (uint32_t)(comma - p);
+            p = comma + 1;
+        }
+        rows.push_back(row);
+    });
+}
+
+// Split a whole file into rows (in file order), over `threads` threads (0 = one per core)
+void splitRows(const mappedFile& file, vector<csvRow>& rows, unsigned threads = 0) {
+    vector<const char*> cuts = chunkLines(file, threads);
+    size_t chunks = cuts.size() - 1;
+    rows.clear();
+
+    if (chunks == 1) {
+        rows.reserve(file.size() / 32);  // Rough guess at the row length, to avoid most regrowth
+        splitRows(cuts[0], cuts[1], rows);
+        return;
+    }
+
+    vector<vector<csvRow>> parts(chunks);
+    vector<thread> pool;
+    for (size_t t = 0; t < chunks; t++) {
+        pool.push_back(thread([&, t]() {
+            parts[t].reserve((cuts[t + 1] - cuts[t]) / 32);
+            splitRows(cuts[t], cuts[t + 1], parts[t]);
+        }));
+    }
+    for (thread& th : pool) th.join();
+
+    size_t total = 0;
+    for (const vector<csvRow>& part : parts) total += part.size();
+    rows.reserve(total);
+    for (const vector<csvRow>& part : parts) rows.insert(rows.end(), part.begin(), part.end());
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef _DEGREEINDEX_H_
+#define _DEGREEINDEX_H_
+
+/*
+Degree index:
+-Keeps every user ranked by degree, so the most connected users are simply the front of an array:
+    top-k costs O(k), with no pass over the graph
+-One degreeRank per ranking: followers + following (total), followers alone (in) and following alone (out)
+-A degreeRank is the users sorted by degree, highest first, cut into buckets of equal degree:
+    -order: the user IDs in that order, and pos: where each user sits in it
+    -above[d]: how many users have a degree above d, which is also where bucket d starts
+    -A user going from d to d + 1 swaps with the first user of bucket d and bucket d shrinks by one
+        (above[d]++); going from d to d - 1 swaps with the last user of bucket d (above[d - 1]--)
+    -So every follow or unfollow is O(1) per ranking
+-build() ranks everyone from scratch with a counting sort, O(users + max degree), after bulk loads;
+    it leaves tied users in ID order, and later updates may reorder users within a bucket
+-Scores that can jump by a lot at once (graph's followers' followers reach, which moves by a whole follower count
+    per follow) go in a scoreRank instead: an ordered set of (score, ID) keys, so any change is O(log users)
+    whatever its size, and nothing is sized by the largest score
+*/
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+class degreeRank {
+private:
+    vector<uint32_t> order;        // User IDs, highest degree first
+    vector<uint32_t> pos;          // pos[id] = index of id in order
+    vector<uint32_t> deg;          // deg[id] = the user's degree
+    vector<uint32_t> above;        // above[d] = number of users with degree > d (bucket d starts there)
+
+    void place(uint32_t id, uint32_t at) {  // Put id at index `at` of order
+        order[at] = id;
+        pos[id] = at;
+    }
+
+public:
+    // Rank n users whose degrees are degree(0) ... degree(n - 1)
+    template <typename F>
+    void build(uint32_t n, F degree) {
+        deg.resize(n);
+        uint32_t maxDeg = 0;
+        for (uint32_t id = 0; id < n; id++) maxDeg = max(maxDeg, deg[id] = (uint32_t)degree(id));
+
+        // Counting sort by degree, descending; IDs stay in increasing order within each bucket
+        above.assign(maxDeg + 2, 0);
+        for (uint32_t id = 0; id < n; id++) above[deg[id]]++;
+        uint32_t more = 0;  // Users with a higher degree than the bucket being visited
+        for (uint32_t d = maxDeg + 1; d-- > 0; ) {
+            uint32_t c = above[d];
+            above[d] = more;
+            more += c;
+        }
+        order.resize(n);
+        pos.resize(n);
+        vector<uint32_t> fill(above);
+        for (uint32_t id = 0; id < n; id++) place(id, fill[deg[id]]++);
+    }
+
+    void increment(uint32_t id) {  // id's degree goes up by one
+        uint32_t d = deg[id]++;
+        if (above.size() < d + 3) above.resize(d + 3, 0);  // Nobody has a degree above the new maximum
+        uint32_t first = above[d];  // First user of bucket d
+        uint32_t other = order[first];
+        place(other, pos[id]);
+        place(id, first);
+        above[d]++;
+    }
+
+    void decrement(uint32_t id) {  // id's degree goes down by one
+        uint32_t d = deg[id]--;
+        uint32_t last = above[d - 1] - 1;  // Last user of bucket d
+        uint32_t other = order[last];
+        place(other, pos[id]);
+        place(id, last);
+        above[d - 1]--;
+    }
+
+    const uint32_t* top() const { return order.data(); }  // Users by degree, highest first
+    uint32_t rankOf(uint32_t id) const { return pos[id]; }  // Index of id in top()
+    uint32_t size() const { return (uint32_t)order.size(); }
+    uint32_t degree(uint32_t id) const { return deg[id]; }
+    void clear() {
+        vector<uint32_t>().swap(order);
+        vector<uint32_t>().swap(pos);
+        vector<uint32_t>().swap(deg);
+        vector<uint32_t>().swap(above);
+    }
+};
+
+class scoreRank {
+private:
+    set<uint64_t> ranked;          // key(score, id) of every user, highest score first (ties by lower ID)
+    vector<uint32_t> scores;       // scores[id] = the user's score
+
+    static uint64_t key(uint32_t score, uint32_t id) { return (uint64_t)(uint32_t)~score << 32 | id; }
+
+public:
+    // Rank n users whose scores are score(0) ... score(n - 1), O(n log n)
+    template <typename F>
+    void build(uint32_t n, F score) {
+        scores.resize(n);
+        vector<uint64_t> keys(n);
+        for (uint32_t id = 0; id < n; id++) keys[id] = key(scores[id] = (uint32_t)score(id), id);
+        sort(keys.begin(), keys.end());
+        ranked = set<uint64_t>(keys.begin(), keys.end());  // Linear from a sorted range
+    }
+
+    void adjust(uint32_t id, int64_t delta) {  // id's score changes by delta, O(log n) for any delta
+        if (!delta) return;
+        ranked.erase(key(scores[id], id));
+        scores[id] = (uint32_t)(scores[id] + delta);
+        ranked.insert(key(scores[id], id));
+    }
+
+    vector<uint32_t> top(int k) const {  // The k highest scoring users, best first, O(k)
+        vector<uint32_t> ids;
+        for (set<uint64_t>::const_iterator it = ranked.begin(); it != ranked.end() && (int)ids.size() < k; ++it) ids.push_back((uint32_t)*it);
+        return ids;
+    }
+
+    uint32_t score(uint32_t id) const { return scores[id]; }
+    void clear() {
+        set<uint64_t>().swap(ranked);
+        vector<uint32_t>().swap(scores);
+    }
+};
+
+enum degreeKind { degreeTotal, degreeIn, degreeOut };  // Followers + following, followers, following
+
+struct degreeIndex {
+    degreeRank ranks[3];           // One ranking per degreeKind
+    bool ready;                    // Whether the rankings match the graph (false until built, and after bulk changes)
+
+    degreeIndex() : ready(false) {}
+
+    // Rank n users from their follower and following counts
+    template <typename F, typename G>
+    void build(uint32_t n, F followers, G following) {
+        ranks[degreeTotal].build(n, [&](uint32_t id) { return followers(id) + following(id); });
+        ranks[degreeIn].build(n, followers);
+        ranks[degreeOut].build(n, following);
+        ready = true;
+    }
+
+    void follow(uint32_t u, uint32_t v) {  // u started following v
+        ranks[degreeOut].increment(u);
+        ranks[degreeIn].increment(v);
+        ranks[degreeTotal].increment(u);
+        ranks[degreeTotal].increment(v);
+    }
+
+    void unfollow(uint32_t u, uint32_t v) {  // u stopped following v
+        ranks[degreeOut].decrement(u);
+        ranks[degreeIn].decrement(v);
+        ranks[degreeTotal].decrement(u);
+        ranks[degreeTotal].decrement(v);
+    }
+
+    void reset() {  // Drop the rankings; the next query builds them again
+        for (degreeRank& r : ranks) r.clear();
+        ready = false;
+    }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef _FLATMAP_H_
+#define _FLATMAP_H_
+
+/*
+Flat map:
+-Open-addressing hash table alternative to the AVL tree for the graph's vertex index (see vertexIndex.h)
+-One flat array of (hash, user*) slots: a lookup hashes the username once and usually lands on the right slot,
+    about one cache miss instead of one per tree level
+-Linear probing, kept at most 3/4 full; the stored hash is compared first so whole usernames are
+    only compared on a real match
+-Remove uses backward-shift deletion, so no tombstones build up
+-No ordering: getArr sorts its output by username to match the other indexes
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "adjList.h"
+using namespace std;
+
+class flatMap {
+private:
+    struct slot {
+        size_t hash;  // Hash of the username
+        user* val;  // User stored in the slot (nullptr if empty)
+    };
+
+    slot* slots;  // The table
+    size_t cap;  // Number of slots (a power of two)
+    size_t size;  // Number of users stored
+
+    size_t findSlot(const string& k, size_t h) const;  // Slot holding k, or the empty slot that ends its probe run
+    void grow(size_t newCap);  // Rehash into newCap slots
+
+public:
+    flatMap();  // Constructor
+    flatMap(user** arr, int len, bool sorted = false);  // Bulk-load constructor
+    ~flatMap();  // Destructor
+
+    user** getArr(int len) const;  // Method to get an array of all users in username order
+    int bulkLoad(user** arr, int len, bool sorted = false);  // Method to fill an empty map from a batch of users
+    void clear();  // Method to empty the map
+    bool insert(user* k);  // Method to insert a user into the map
+    bool remove(const string& k);  // Method to remove a user by username
+    user* retrieve(const string& k) const;  // Method to retrieve a user by username
+};
+
+flatMap::flatMap() : slots(nullptr), cap(0), size(0) {
+    grow(16);
+}
+
+flatMap::flatMap(user** arr, int len, bool sorted) : slots(nullptr), cap(0), size(0) {
+    grow(16);
+    bulkLoad(arr, len, sorted);
+}
+
+flatMap::~flatMap() {
+    delete[] slots;
+}
+
+size_t flatMap::findSlot(const string& k, size_t h) const {
+    size_t i = h & (cap - 1);
+    while (slots[i].val && (slots[i].hash != h || slots[i].val->username != k)) i = (i + 1) & (cap - 1);
+    return i;
+}
+
+void flatMap::grow(size_t newCap) {
+    slot* old = slots;
+    size_t oldCap = cap;
+    slots = new slot[newCap]();
+    cap = newCap;
+    for (size_t i = 0; i < oldCap; i++) {
+        if (!old[i].val) continue;
+        size_t j = old[i].hash & (cap - 1);
+        while (slots[j].val) j = (j + 1) & (cap - 1);
+        slots[j] = old[i];
+    }
+    delete[] old;
+}
+
+bool flatMap::insert(user* k) {
+    size_t h = hash<string>()(k->username);
+    size_t i = findSlot(k->username, h);
+    if (slots[i].val) return false;  // Username already taken
+
+    if (4 * (size + 1) > 3 * cap) {  // Too full: grow, then find the new empty slot
+        grow(cap * 2);
+        i = findSlot(k->username, h);
+    }
+    slots[i].hash = h;
+    slots[i].val = k;
+    size++;
+    return true;
+}
+
+bool flatMap::remove(const string& k) {
+    size_t i = findSlot(k, hash<string>()(k));
+    if (!slots[i].val) return false;  // Not in the map
+
+    // Backward-shift deletion: pull later entries of the probe run into the gap
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & (cap - 1);
+        if (!slots[j].val) break;
+        size_t home = slots[j].hash & (cap - 1);
+        if (((j - home) & (cap - 1)) >= ((j - i) & (cap - 1))) {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i].val = nullptr;
+    size--;
+    return true;
+}
+
+user* flatMap::retrieve(const string& k) const {
+    return slots[findSlot(k, hash<string>()(k))].val;
+}
+
+void flatMap::clear() {
+    delete[] slots;
+    slots = nullptr;
+    cap = 0;
+    size = 0;
+    grow(16);
+}
+
+int flatMap::bulkLoad(user** arr, int len, bool) {
+    if (size) return 0;  // Only an empty map can be bulk-loaded
+
+    size_t want = 16;
+    while (4 * (size_t)len > 3 * want) want *= 2;  // Size the table once up front
+    if (want > cap) grow(want);
+
+    int loaded = 0;
+    for (int i = 0; i < len; i++) loaded += insert(arr[i]);  // Order does not matter to a hash table
+    return loaded;
+}
+
+user** flatMap::getArr(int len) const {
+    user** arr = new user*[len];
+    int n = 0;
+    for (size_t i = 0; i < cap && n < len; i++) {
+        if (slots[i].val) arr[n++] = slots[i].val;
+    }
+    sort(arr, arr + n, [](user* a, user* b) { return a->username < b->username; });
+    return arr;
+}
+
+#endif
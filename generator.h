@@ -0,0 +1,239 @@
+#ifndef _GENERATOR_H_
+#define _GENERATOR_H_
+
+/*
+Generator:
+-Synthetic follow networks for load-testing the analytics at any size, independent of user_data.csv
+-Every network is fully determined by its parameters and seed: the same genParams give the same users and follows
+    on every run and with any number of threads
+-Models:
+    -uniform: every follow picks both users uniformly at random (what the graph constructor always did)
+    -Barabasi-Albert: each new user is linked to m earlier users picked in proportion to their degree, which gives
+        a power-law degree distribution; each link's direction is a coin flip, so the network is not acyclic
+    -R-MAT: each follow drops into one quadrant of the adjacency matrix per level with probabilities a, b, c, d,
+        which gives skewed degrees on both sides plus community-like structure
+    -Chung-Lu: users get power-law expected degrees, and each follow picks its follower and followed users in
+        proportion to them (independent orderings, so big accounts to follow are not the same users who follow a lot);
+        users are drawn from an alias table in O(1)
+-Users are relabeled with a seeded random permutation, so the hubs are not simply the lowest IDs
+-Follows are made in fixed-size blocks handed out to threads; each block has its own seed, which is what keeps the
+    output independent of the thread count. Barabasi-Albert is made parallel with the edge-copy formulation:
+    each endpoint is a hash-picked earlier endpoint, resolved independently by walking back to a fixed one
+-Output is a list of packed (follower << 32) | followed keys, which graph::generate feeds to the bulk follow path
+    and generateSnapshot turns straight into a snapshot file (see snapshot.h) without building adjacency lists
+-Users are named user0...0<ID>, zero-padded so that ID order is username order, with a first and last name picked by hash
+*/
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include "csr.h"
+#include "radixSort.h"
+#include "snapshot.h"
+using namespace std;
+
+enum genModel { genUniform, genBarabasiAlbert, genRmat, genChungLu };
+
+struct genParams {
+    genModel model;                // Which model to use
+    uint32_t users;                // Number of users
+    uint64_t follows;              // Number of follows to make (repeats and self-follows are dropped afterwards)
+    uint64_t seed;                 // Seed for everything random
+    unsigned threads;              // Threads to generate with (0 = one per core)
+    double rmatA, rmatB, rmatC;    // R-MAT quadrant probabilities (d = 1 - a - b - c)
+    double exponent;               // Chung-Lu power-law exponent of the degree distribution (above 2)
+
+    genParams(genModel m = genUniform, uint32_t n = 0, uint64_t f = 0, uint64_t s = 1)
+        : model(m), users(n), follows(f), seed(s), threads(0), rmatA(0.57), rmatB(0.19), rmatC(0.19), exponent(2.3) {}
+};
+
+// Model from its command-line name (uniform, ba, rmat, chunglu); false if the name is unknown
+bool parseGenModel(const string& name, genModel& model) {
+    if (name == "uniform") model = genUniform;
+    else if (name == "ba") model = genBarabasiAlbert;
+    else if (name == "rmat") model = genRmat;
+    else if (name == "chunglu") model = genChungLu;
+    else return false;
+    return true;
+}
+
+// SplitMix64 finalizer: a well-mixed 64-bit hash of x
+uint64_t genMix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Map a 64-bit hash onto [0, range) without a division
+uint64_t genBelow(uint64_t h, uint64_t range) {
+    return (uint64_t)(((unsigned __int128)h * range) >> 64);
+}
+
+// A seeded random ordering of 0 ... n - 1
+vector<uint32_t> genPermutation(uint32_t n, uint64_t seed) {
+    vector<uint32_t> perm(n);
+    for (uint32_t i = 0; i < n; i++) perm[i] = i;
+    mt19937_64 gen(genMix(seed));
+    for (uint32_t i = n; i > 1; i--) swap(perm[i - 1], perm[genBelow(gen(), i)]);
+    return perm;
+}
+
+// Username (f = 0), firstname (1) or lastname (2) of a generated user
+string genField(const genParams& p, uint32_t id, int f) {
+    static const char* firsts[] = {"John", "Jane", "Chris", "Emily", "David", "Maria", "James", "Sofia", "Michael", "Olivia"};
+    static const char* lasts[] = {"Miller", "Garcia", "Brown", "Rodriguez", "Smith", "Johnson", "Lee", "Martinez", "Davis", "Lopez"};
+    if (f == 1) return firsts[genMix(p.seed ^ ((uint64_t)id << 1)) % 10];
+    if (f == 2) return lasts[genMix(p.seed ^ ((uint64_t)id << 1 | 1)) % 10];
+
+    string digits = to_string(id);
+    size_t width = to_string(p.users ? p.users - 1 : 0).size();
+    return "user" + string(width - digits.size(), '0') + digits;
+}
+
+// Make the follows of the network described by p, packed as (follower << 32) | followed, in a fixed order
+void generateEdges(const genParams& p, vector<uint64_t>& keys) {
+    const uint64_t blockSize = 1 << 16;  // Follows per block (and per block seed)
+    uint32_t n = p.users;
+    keys.clear();
+    if (!n) return;
+
+    // Barabasi-Albert makes m follows per user; the other models make exactly p.follows
+    uint64_t m = max<uint64_t>(1, (p.follows + n / 2) / n);
+    uint64_t total = p.model == genBarabasiAlbert ? m * n : p.follows;
+    keys.resize(total);
+
+    vector<uint32_t> perm, permIn;  // Relabelings (for Chung-Lu, one per side)
+    if (p.model != genUniform) perm = genPermutation(n, p.seed ^ 0x5045524D);
+    if (p.model == genChungLu) permIn = genPermutation(n, p.seed ^ 0x494E5045);
+
+    // Chung-Lu: alias table over the power-law expected degrees (w_i = (i + 1)^(-1 / (exponent - 1)))
+    // Slot i keeps user i with probability keep[i] / 2^32 and hands the rest to user alias[i]
+    vector<uint32_t> keep, alias;
+    if (p.model == genChungLu) {
+        double alpha = 1.0 / max(p.exponent - 1.0, 1e-3);
+        vector<double> w(n);
+        double sum = 0;
+        for (uint32_t i = 0; i < n; i++) sum += (w[i] = pow(i + 1.0, -alpha));
+        keep.assign(n, UINT32_MAX);
+        alias.resize(n);
+        vector<uint32_t> small, large;
+        for (uint32_t i = 0; i < n; i++) {
+            alias[i] = i;
+            w[i] *= n / sum;  // Scale so the average weight is 1
+            (w[i] < 1.0 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty()) {  // Top up each light slot from a heavy user
+            uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            keep[s] = (uint32_t)(w[s] * 4294967296.0);
+            alias[s] = l;
+            w[l] -= 1.0 - w[s];
+            if (w[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+    }
+    auto aliasDraw = [&](uint64_t r) {  // One 64-bit random number picks a slot (high bits) and a side (low 32 bits)
+        uint32_t i = (uint32_t)genBelow(r, n);
+        return (uint32_t)r < keep[i] ? i : alias[i];
+    };
+
+    // R-MAT: levels of quadrant picks needed to cover n users, and the quadrant thresholds out of 2^16
+    int levels = 0;
+    while (levels < 32 && (1ull << levels) < n) levels++;
+    uint32_t cutA = (uint32_t)(p.rmatA * 65536), cutB = (uint32_t)((p.rmatA + p.rmatB) * 65536), cutC = (uint32_t)((p.rmatA + p.rmatB + p.rmatC) * 65536);
+
+    // Barabasi-Albert: follow e is array slot 2e (follower, user e / m) and 2e + 1 (followed); the followed slot copies
+    // a hash-picked earlier slot, which picks a user in proportion to how often they already appear (their degree)
+    auto baUser = [&](uint64_t e) {
+        uint64_t pos = 2 * e + 1;
+        while (pos & 1) {  // A followed slot: jump to the slot it copies
+            uint64_t slot = (pos - 1) / 2;
+            pos = slot ? genBelow(genMix(p.seed ^ (pos * 0xD1B54A32D192ED03ull)), 2 * slot) : 0;  // The very first follow points at user 0
+        }
+        return (uint32_t)(pos / 2 / m);  // A follower slot holds its own user
+    };
+
+    uint64_t blocks = (total + blockSize - 1) / blockSize;
+    atomic<uint64_t> nextBlock(0);
+    auto worker = [&]() {
+        for (uint64_t b = nextBlock++; b < blocks; b = nextBlock++) {
+            mt19937_64 gen(genMix(p.seed + b * 0x632BE59BD9B4E019ull));
+            uint64_t end = min(total, (b + 1) * blockSize);
+
+            for (uint64_t e = b * blockSize; e < end; e++) {
+                uint32_t u = 0, v = 0;
+                switch (p.model) {
+                case genUniform:
+                    u = (uint32_t)genBelow(gen(), n);
+                    v = (uint32_t)genBelow(gen(), n);
+                    break;
+                case genBarabasiAlbert:
+                    u = perm[e / m];
+                    v = perm[baUser(e)];
+                    if (genMix(p.seed ^ e) & 1) swap(u, v);  // Either side may be the follower
+                    break;
+                case genRmat:
+                    do {  // Descend one quadrant per level; retry the rare picks past the last user
+                        u = v = 0;
+                        uint64_t bits = 0;
+                        for (int l = 0; l < levels; l++) {
+                            if (!(l & 3)) bits = gen();  // Four 16-bit draws per random number
+                            uint32_t r = (uint32_t)(bits >> (16 * (l & 3))) & 0xFFFF;
+                            int q = r < cutA ? 0 : r < cutB ? 1 : r < cutC ? 2 : 3;
+                            u = u << 1 | (q >> 1);
+                            v = v << 1 | (q & 1);
+                        }
+                    } while (u >= n || v >= n);
+                    u = perm[u];
+                    v = perm[v];
+                    break;
+                case genChungLu:
+                    u = perm[aliasDraw(gen())];
+                    v = permIn[aliasDraw(gen())];
+                    break;
+                }
+                keys[e] = (uint64_t)u << 32 | v;
+            }
+        }
+    };
+
+    unsigned threads = p.threads ? p.threads : max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<uint64_t>(1, min<uint64_t>(threads, blocks));
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.push_back(thread(worker));
+    worker();
+    for (thread& th : pool) th.join();
+}
+
+// Generate the network described by p straight into a snapshot file, with no adjacency lists in between
+// Returns the number of distinct follows written, or -1 if the file can't be written
+int64_t generateSnapshot(const genParams& p, const string& path) {
+    vector<uint64_t> keys;
+    generateEdges(p, keys);
+
+    // Same cleanup as graph::bulkFollow: no self-follows, no repeats, grouped by follower
+    keys.erase(remove_if(keys.begin(), keys.end(), [](uint64_t k) { return (uint32_t)(k >> 32) == (uint32_t)k; }), keys.end());
+    radixSort(keys, p.threads);
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+    csrGraph* g = csrFromKeys(p.users, keys);
+    vector<uint64_t>().swap(keys);  // The snapshot has everything now
+
+    vector<uint32_t> order(p.users);  // Zero-padded usernames sort in ID order
+    for (uint32_t i = 0; i < p.users; i++) order[i] = i;
+    bool ok = writeSnapshot(path, *g, order.data(), [&p](uint32_t id, int f) { return genField(p, id, f); });
+
+    int64_t written = ok ? (int64_t)g->numEdges : -1;
+    delete g;
+    return written;
+}
+
+#endif
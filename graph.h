@@ -3,50 +3,169 @@
 
 /*
 Graph:
--AVL tree of all nodes
+-AVL tree of all nodes (or another vertex index picked at compile time, see vertexIndex.h)
 -Nodes store all edges
 -Edges store nodes
--AVL tree performs memory management
--String array to allow for indexing of users
+-A memory arena of slab pools (see pool.h and adjList.h) performs memory management for users, lists and edges
+-Users are numbered with dense IDs (0 ... numUsrs - 1); an array of users by ID allows for indexing of users
+-Each username is stored once, in its user; string lookups go through the AVL tree and everything else uses IDs
 -Integers to store total number of users and total number of connections
 -Methods added to allow for computations
+-user_data.csv is memory-mapped and split in place in a single pass (see csvLoader.h)
+-freeze() packs the edges into a CSR snapshot (see csr.h) that the analytics run against
+-Follows are added in bulk (bulkFollow, loadEdges): the batch is grouped and deduped with a radix sort,
+    then every following and followers list gets its new users in one pass, split over threads by user
+-Many threads can stage follows at once through a followIngest (see ingest.h): each appends to its own
+    buffer with no locks, and compact() dedupes and adds the lot through bulkFollow
+-follow/unfollow change single edges; the CSR snapshot is dropped and rebuilt by the next query
+    (only when an edge really changes: a repeated follow or a missing unfollow leaves it alone)
+-removeUser takes a user out in O(degree): their edges are unlinked through the lists' membership indexes,
+    and the user with the last ID moves into the freed one so IDs stay dense
+-The destructor is O(users + edges): users give back their strings and indexes, then the arena and the
+    vertex index drop their slabs whole, with no edge unlinked one at a time
+-Users are also kept ranked by degree (see degreeIndex.h): follow/unfollow re-rank the two users in O(1),
+    so mostConnected reads the top users straight off the ranking
+-Friend suggestions count friends of friends with dense per-thread counters (see suggest.h), and can be
+    made for every user at once on all cores (suggestFriendsAll)
+-Each user's last suggestions are cached; follow/unfollow drop only the entries of the follower and their followers,
+    the only users whose friends of friends changed
+-Reach (followers' followers) is ranked too, in an ordered set (see degreeIndex.h): a follow changes the followed user's
+    reach by the follower's follower count and everyone they follow by one, so mostReaching is O(k) and
+    follow/unfollow O(degree log users)
+-A liveGraph (see liveGraph.h) serves queries from many threads while one writer applies batches of follows:
+    readers run against immutable CSR versions that the writer publishes with an atomic pointer swap; versions are
+    paged (see pagedCsr.h) and share every page a batch leaves alone, so a publish copies only the touched rows' pages
+-main -serve keeps a loaded network in memory and answers pipelined commands (suggest, sep, top-connected, ...)
+    from stdin or a Unix socket (see server.h)
+-Synthetic networks of any size come from the seeded generator (see generator.h), either into a graph (generate)
+    or straight into a snapshot file (generateSnapshot)
+-saveSnapshot()/loadSnapshot() write and memory-map a binary image of the network (see snapshot.h):
+    a loaded network runs its analytics straight off the mapped CSR arrays, and the adjacency lists
+    are only rebuilt from them (buildLists) once something needs to change an edge
+-Building with GRAPH_STATS times every load, edge change and query, and dumpStats() prints the timings
+    together with the AVL and adjacency list lookup costs (see stats.h)
 */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <cstdio>
 #include <random>
 #include <queue>
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
 #include <vector>
+#include <thread>
 #include "adjList.h"
-#include "avl.h"
+#include "vertexIndex.h"
+#include "csvLoader.h"
+#include "snapshot.h"
+#include "radixSort.h"
+#include "generator.h"
+#include "csr.h"
+#include "degreeIndex.h"
+#include "bfs.h"
+#include "suggest.h"
+#include "msbfs.h"
+#include "scc.h"
+#include "pagerank.h"
+#include "betweenness.h"
+#include "stats.h"
 using namespace std;
 
+// Print a pool's usage next to what one heap allocation per object would have cost
+// (glibc malloc rounds each request plus an 8-byte header up to 16 bytes, with a 32-byte minimum)
+template <typename T>
+void printPoolStats(const string& name, const memPool<T>& pool) {
+    size_t perObject = max<size_t>(32, (sizeof(T) + 8 + 15) & ~(size_t)15);
+    cout << name << ": " << pool.live() << " live, " << pool.made() << " made; "
+         << pool.slabCt() << " heap allocations instead of " << pool.made() << ", "
+         << pool.bytes() << " bytes instead of about " << pool.live() * perObject << endl;
+}
+
+// forFollowing over the adjacency lists (see suggest.h), for when there is no current CSR snapshot
+struct listFollowing {
+    user** users;
+    listFollowing(user** u) : users(u) {}
+    template <typename V>
+    void operator()(uint32_t x, V visit) const {
+        for (aNode* cur = users[x]->following->first(); cur; cur = cur->next) visit(cur->id);
+    }
+};
+
 class graph {
 private:
-    AVL vertices;                  // AVL tree to store users (for efficient insertion and retrieval)
-    string* usernames;             // Array of usernames
+    memArena mem;                  // Pools the users, their lists and their edges are allocated from
+    vertexIndex vertices;          // AVL tree (by default) to store users (for efficient insertion and retrieval)
+    user** users;                  // Array of users by ID
     int numUsrs;                   // Total number of users in the graph
     int numCncts;                  // Total number of connections (follows)
+    csrGraph* frozen;              // CSR snapshot used by the analytics (nullptr until freeze() is called)
+    mappedFile* snapshot;          // Snapshot file the network was loaded from (nullptr if it was built here)
+    bool listsPending;             // Edges are only in the loaded snapshot so far, not in the adjacency lists
+    degreeIndex degrees;           // Users ranked by degree (kept up to date by follow/unfollow, rebuilt after bulk changes)
+    scoreRank reach;               // Users ranked by their followers' follower counts (likewise)
+    bool reachReady;               // Whether reach matches the graph
+    bfsEngine bfs;                 // Reusable scratch space for separation queries
+    msBfs multiBfs;                // Reusable scratch space for batched separation queries
+    suggestEngine suggester;       // Reusable scratch space for friend suggestions
+    suggestCache friendCache;      // Each user's last friend suggestions (dropped when their two-hop neighborhood changes)
+
+    static const int maxAllPairs = 50000;  // Largest network the all-pairs distance statistics will run on
+    static const int maxExactBetweenness = 20000;  // Largest network that gets exact (rather than sampled) bridge users
 
     // Private helper functions
+    void clear();                  // Free every user, edge and snapshot, leaving an empty network
+    void buildLists();             // Fill the adjacency lists from a loaded snapshot (before any edge changes)
+    void thaw();                   // Get ready to change edges: fill in the lists and drop the CSR snapshot
+    bool isFollowing(int follower, int followed);  // Whether follower follows followed (IDs already checked)
+    void dropSuggestions(int follower);  // Drop the cached suggestions that a follow or unfollow by follower made stale
+    void updateReach(int follower, int followed, int sign);  // Re-rank the users whose reach a follow (+1) or unfollow (-1) changed
+    uint64_t addEdges(vector<uint64_t>& keys, unsigned threads);  // Add packed (follower << 32 | followed) edges in one pass
+    bool readUsers(const string& path);  // Read the users from a CSV file
+    void loadUsers();              // Drop duplicate usernames, renumber, and bulk-load the AVL tree
     user* getUser(int index);      // Retrieve a user by their index
-    user** suggestFriends(string username, int resultCt); // Suggest friends for a given user
-    user** mostConnected(int resultCt); // Find the most connected users based on followers/following
-    user** mostInfluential(int resultCt); // Find the most influential users based on influence score
+    user** mostBetween(int resultCt);     // Find the users with the highest betweenness centrality
 
 public:
     graph();      // Constructor to initialize the graph and load user data
+    explicit graph(const string& snapshotPath);  // Constructor to open a saved snapshot instead
+    graph(const string& csvPath, const string& edgePath, bool edgeIds = false);  // Constructor to load users and real follows from files
+    explicit graph(const genParams& params);  // Constructor to generate a synthetic network
     ~graph();     // Destructor to clean up dynamically allocated memory
 
     // Public methods
+    const csrGraph& freeze();               // Build (or reuse) the CSR snapshot of the current edges
+    bool saveSnapshot(const string& path);  // Write the network to a snapshot file
+    bool loadSnapshot(const string& path);  // Replace the network with one from a snapshot file
+    uint64_t bulkFollow(const vector<pair<uint32_t, uint32_t>>& follows, unsigned threads = 0);  // Add many follows (by ID) at once
+    uint64_t bulkFollow(vector<uint64_t>& keys, unsigned threads = 0);  // Same for follows packed as (follower << 32) | followed (sorted and deduped in place)
+    int64_t loadEdges(const string& path, bool byId = false, unsigned threads = 0);  // Add the follows listed in an edge file
+    bool follow(string username1, string username2);  // Make username1 follow username2 (false if either doesn't exist or the follow isn't new)
+    bool follow(int index1, int index2);    // Overloaded function to follow by index
+    bool unfollow(string username1, string username2);  // Make username1 stop following username2 (false if there was no such follow)
+    bool unfollow(int index1, int index2);  // Overloaded function to unfollow by index
+    bool removeUser(string username);       // Remove a user and all of their follows (false if there is no such user); the last user takes over their index
+    int userIndex(string username);         // Return the index of a user by username (-1 if there is none)
+    string username(int index);             // Return the username of a user by index ("" if there is none)
+    user** suggestFriends(string username, int resultCt, int* found = nullptr); // Suggest friends for a given user, found of them (be sure to delete the array!)
+    void suggestFriends(const vector<uint32_t>& ids, int resultCt, vector<uint32_t>& suggestions, vector<int>& found, unsigned threads = 0);  // Batched overload, in parallel: ids[i]'s suggestions are suggestions[i * resultCt ...], found[i] of them
+    void suggestFriendsAll(int resultCt, vector<uint32_t>& suggestions, vector<int>& found, unsigned threads = 0);  // Same for every user (row i is user i)
+    user** mostConnected(int resultCt, degreeKind by = degreeTotal);  // Find the users with the most followers + following (or either alone) (be sure to delete the array!)
+    user** mostInfluential(int resultCt);   // Find the most influential users based on PageRank (be sure to delete the array!)
+    user** mostReaching(int resultCt);      // Find the users whose followers have the most followers (be sure to delete the array!)
+    void generate(const genParams& params);  // Replace the network with a generated one
     int usrCt();                            // Return total number of users in the graph
+    int followCt();                         // Return total number of follows in the graph
     int avgConnectionCT();                  // Return average number of connections per user
     int sepDegree(string username1, string username2);  // Return degree of separation between two users by usernames
     int sepDegree(int index1, int index2);  // Overloaded function to find separation by index
+    int sepDegree(string username1, string username2, vector<user*>& path);  // Overload that also returns the shortest path (username1 ... username2)
+    void sepDegree(const int* index1, const int* index2, int* degrees, int n);  // Batched overload: degrees[k] = separation of index1[k] and index2[k]
+    void distancesFrom(const int* sources, int n, int* degrees);  // degrees[k * usrCt() + i] = separation of sources[k] and user i
+    bool distanceHistogram(vector<uint64_t>& hist, int* diameter);  // All-pairs distance counts and diameter (false if the network is too large)
+    int pageRank(vector<double>& rank, double damping = 0.85, double tolerance = 1e-9, unsigned threads = 0);  // PageRank of each user (by index); returns the iterations run
+    int betweenness(vector<double>& bc, double epsilon = 0, double failProb = 0.1, uint64_t seed = 1);  // Betweenness of each user (by index), exact when epsilon = 0; returns the sources used
+    int stronglyConnected(vector<uint32_t>& compOf, vector<uint32_t>& sizes);  // Component of each user (by index) and size of each component; returns the count
 
     // Printing methods for debugging and output
     void print();                           // Print all users and their connections
@@ -54,203 +173,829 @@ public:
     void printFriendSuggestions(int index, int resultCt);         // Overloaded function to print suggestions by user index
     void printSeparationDegree(string username1, string username2); // Print degree of separation between two users by usernames
     void printSeparationDegree(int index1, int index2);  // Overloaded function to print degree of separation by index
+    void printSeparationDegrees(const int* index1, const int* index2, int n);  // Print a batch of separation degrees by index
+    void printDistanceStats();                           // Print the distance histogram and diameter
+    void printTopComponents(int resultCt);               // Print the largest strongly connected components
     void printMostConnectedUser(int resultCt);           // Print most connected users
     void printMostInfluentialUser(int resultCt);         // Print most influential users
+    void printMostReachingUser(int resultCt);            // Print users with the largest followers' followers reach
+    void printBridgeUsers(int resultCt);                 // Print users with the highest betweenness centrality
     void printNumberOfUsers();                           // Print total number of users
     void printAverageNumberOfConnections();              // Print average number of connections per user
+    void printMemoryStats();                             // Print the arena's allocation counts and bytes
+    uint64_t suggestCacheHits();                         // Return how many suggestion requests the cache answered
+    uint64_t suggestCacheMisses();                       // Return how many had to be computed
+    void dumpStats(bool json = false, ostream& out = cout);  // Print the instrumentation counters and latency histograms (see stats.h)
 };
 
 // Constructor to initialize the graph
-graph::graph() {
-    fstream file;
-    file.open("user_data.csv");     // Open the CSV file containing user data
-    if (!file.is_open()) {
-        std::cerr << "Error opening file!" << std::endl;  // Print an error if the file doesn't open
-        return;
+graph::graph() : users(nullptr), numUsrs(0), numCncts(0), frozen(nullptr), snapshot(nullptr), listsPending(false), reachReady(false) {
+    if (!readUsers("user_data.csv")) return;
+
+    // Generate random user connections (follow relationships) with a fixed seed, so every run sees the same network;
+    // repeats and self-follows are dropped on the way in
+    vector<uint64_t> keys;
+    generateEdges(genParams(genUniform, numUsrs, (uint64_t)numUsrs * 30, 1), keys);
+    addEdges(keys, 0);
+}
+
+// Constructor to generate a synthetic network (see generate)
+graph::graph(const genParams& params) : users(nullptr), numUsrs(0), numCncts(0), frozen(nullptr), snapshot(nullptr), listsPending(false), reachReady(false) {
+    generate(params);
+}
+
+// Constructor to load the users from a CSV file and their follows from an edge file (see loadEdges)
+graph::graph(const string& csvPath, const string& edgePath, bool edgeIds) : users(nullptr), numUsrs(0), numCncts(0), frozen(nullptr), snapshot(nullptr), listsPending(false), reachReady(false) {
+    if (!readUsers(csvPath)) return;
+    if (loadEdges(edgePath, edgeIds) < 0) std::cerr << "Error opening edge file " << edgePath << "!" << std::endl;
+}
+
+// Constructor to open a network saved with saveSnapshot
+graph::graph(const string& snapshotPath) : users(nullptr), numUsrs(0), numCncts(0), frozen(nullptr), snapshot(nullptr), listsPending(false), reachReady(false) {
+    if (!loadSnapshot(snapshotPath)) std::cerr << "Error loading snapshot " << snapshotPath << "!" << std::endl;
+}
+
+// Destructor to free dynamically allocated memory
+graph::~graph() {
+    clear();
+}
+
+// Free every user, edge and snapshot
+void graph::clear() {
+    mem.dropping = true;  // Every node goes when the arena is released, so the lists skip freeing them one by one
+    for (int i = 0; i < numUsrs; i++) mem.users.destroy(users[i]);  // Free each user's strings and membership indexes
+    mem.release();       // Drop the arena's slabs
+    vertices.clear();    // Empty the vertex index
+    delete[] users;      // Deallocate memory for the users array
+    delete frozen;       // Deallocate the CSR snapshot (if one was built); it may point into the snapshot file, so it goes first
+    delete snapshot;     // Unmap the snapshot file (if the network came from one)
+
+    users = nullptr;
+    frozen = nullptr;
+    snapshot = nullptr;
+    numUsrs = numCncts = 0;
+    listsPending = false;
+    degrees.reset();
+    reach.clear();
+    reachReady = false;
+    friendCache.clear();
+}
+
+// Write the network to `path` (see writeSnapshot)
+bool graph::saveSnapshot(const string& path) {
+    STAT_TIME(statSaveSnapshot);
+    const csrGraph& g = freeze();
+
+    // IDs in username order, straight from the vertex index
+    vector<uint32_t> order(numUsrs);
+    user** sorted = vertices.getArr(numUsrs);
+    for (int i = 0; i < numUsrs; i++) order[i] = sorted[i]->id;
+    delete[] sorted;
+
+    return writeSnapshot(path, g, order.data(), [this](uint32_t id, int f) -> const string& {
+        return f == 0 ? users[id]->username : f == 1 ? users[id]->firstname : users[id]->lastname;
+    });
+}
+
+// Replace the network with the one in `path`; on failure (missing file, wrong version, damaged header or sections) the network is left as it was
+// The CSR arrays are used in place from the mapping, and every user gets its strings and follow counts
+bool graph::loadSnapshot(const string& path) {
+    STAT_TIME(statLoadSnapshot);
+    mappedFile* file = new mappedFile;
+    if (!file->open(path) || file->size() < sizeof(snapHeader) || !snapCheck(*(const snapHeader*)file->data(), file->size())) {
+        delete file;
+        return false;
     }
+    const char* base = file->data();
+    const snapHeader& h = *(const snapHeader*)base;
+    const uint64_t* strOff = (const uint64_t*)(base + h.sections[secStrOff]);
+    const char* strData = base + h.sections[secStrData];
+    const uint32_t* order = (const uint32_t*)(base + h.sections[secOrder]);
+    const uint64_t* outOff = (const uint64_t*)(base + h.sections[secOutOff]);
+    const uint64_t* inOff = (const uint64_t*)(base + h.sections[secInOff]);
+    const uint32_t* outAdj = (const uint32_t*)(base + h.sections[secOutAdj]);
+    const uint32_t* inAdj = (const uint32_t*)(base + h.sections[secInAdj]);
+    uint32_t n = h.numNodes;
 
-    string line;
-    numUsrs = 0;                    // Initialize the user count to zero
-    
-    // Count the number of users by reading through the file
-    while(getline(file, line)) numUsrs++;
-    file.close();                   // Close the file after counting users
+    // Checks that keep a damaged file from sending the loader, buildLists or any query out of bounds:
+    // O(n) over the offsets and the username order, then O(edges) over the edges
+    // (rows strictly increasing with no self-follows, as isFollowing's binary search expects, and the in-CSR
+    // exactly the transpose of the out-CSR, since the counts come from one and the lists from the other)
+    // Usernames strictly increasing along `order` proves it is a sorted permutation without repeated names, as bulkLoad expects
+    auto nameBefore = [&](uint32_t a, uint32_t b) {
+        const uint64_t* s = strOff + 3ull * a;
+        const uint64_t* t = strOff + 3ull * b;
+        size_t len = (size_t)min(s[1] - s[0], t[1] - t[0]);
+        int c = char_traits<char>::compare(strData + s[0], strData + t[0], len);
+        return c < 0 || (c == 0 && s[1] - s[0] < t[1] - t[0]);
+    };
+    bool ok = strOff[0] == 0 && strOff[3ull * n] == h.strBytes && outOff[0] == 0 && outOff[n] == h.numEdges && inOff[0] == 0 && inOff[n] == h.numEdges;
+    for (uint64_t j = 0; ok && j < 3ull * n; j++) ok = strOff[j] <= strOff[j + 1];
+    for (uint32_t i = 0; ok && i < n; i++) ok = order[i] < n && outOff[i] <= outOff[i + 1] && inOff[i] <= inOff[i + 1];
+    for (uint32_t i = 1; ok && i < n; i++) ok = nameBefore(order[i - 1], order[i]);
+    for (uint32_t i = 0; ok && i < n; i++) {
+        for (uint64_t j = outOff[i]; ok && j < outOff[i + 1]; j++) ok = outAdj[j] < n && outAdj[j] != i && (j == outOff[i] || outAdj[j - 1] < outAdj[j]);
+    }
+    if (ok) {  // Rebuild the in-CSR from outAdj with a counting sort (sources in ID order leave its rows sorted) and compare
+        vector<uint64_t> off(n + 1, 0);
+        for (uint64_t j = 0; j < h.numEdges; j++) off[outAdj[j] + 1]++;
+        for (uint32_t v = 0; v < n; v++) off[v + 1] += off[v];
+        ok = memcmp(off.data(), inOff, (n + 1ull) * sizeof(uint64_t)) == 0;
+        if (ok) {
+            vector<uint32_t> adj(h.numEdges);
+            for (uint32_t i = 0; i < n; i++) {
+                for (uint64_t j = outOff[i]; j < outOff[i + 1]; j++) adj[off[outAdj[j]]++] = i;
+            }
+            ok = h.numEdges == 0 || memcmp(adj.data(), inAdj, h.numEdges * sizeof(uint32_t)) == 0;
+        }
+    }
+    if (!ok) {
+        delete file;
+        return false;
+    }
 
-    usernames = new string[numUsrs]; // Dynamically allocate the array of usernames
+    clear();
+    snapshot = file;
+    frozen = new csrGraph(n, h.numEdges, outOff, outAdj, inOff, inAdj);
 
-    // Reopen the file to load data
-    file.open("user_data.csv");
-    if (!file.is_open()) {
-        std::cerr << "Error opening file!" << std::endl;
-        return;
+    numUsrs = (int)n;
+    numCncts = (int)h.numEdges;
+    users = new user*[numUsrs];
+    for (uint32_t i = 0; i < n; i++) {
+        const uint64_t* s = strOff + 3 * (uint64_t)i;
+        users[i] = mem.users.make(i, string(strData + s[0], s[1] - s[0]), string(strData + s[1], s[2] - s[1]), string(strData + s[2], s[3] - s[2]), &mem);
+        users[i]->numFollowing = frozen->outDeg(i);  // The counts are right already; the lists wait for buildLists
+        users[i]->numFollowers = frozen->inDeg(i);
     }
-    
-    string username, first_name, last_name;
+    listsPending = true;
+
+    vector<user*> sorted(n);
+    for (uint32_t i = 0; i < n; i++) sorted[i] = users[order[i]];
+    vertices.bulkLoad(sorted.data(), numUsrs, true);
+    return true;
+}
 
-    // Insert users into the AVL tree and populate the usernames array
-    for(int i = 0; getline(file, line); i++) {
-        stringstream row(line);
+// Make the adjacency lists the only copy of the edges; anything that changes an edge calls this first
+// (the lists are filled in if the network came from a snapshot, and the now-stale CSR snapshot is dropped)
+void graph::thaw() {
+    buildLists();
+    delete frozen;
+    frozen = nullptr;
+    delete snapshot;  // The users' strings and edges no longer point into the file
+    snapshot = nullptr;
+}
+
+// Add a batch of follows (follower ID, followed ID) in one pass; returns how many were new
+// Self-follows, unknown IDs, repeats within the batch and follows that already exist are skipped
+uint64_t graph::bulkFollow(const vector<pair<uint32_t, uint32_t>>& follows, unsigned threads) {
+    vector<uint64_t> keys;
+    keys.reserve(follows.size());
+    for (size_t i = 0; i < follows.size(); i++) keys.push_back((uint64_t)follows[i].first << 32 | follows[i].second);
+    return addEdges(keys, threads);
+}
 
-        // Read user data from CSV
-        getline(row, username, ',');
-        getline(row, first_name, ',');
-        getline(row, last_name, ',');
+// Overload of `bulkFollow` for follows that are already packed (see ingest.h); keys is sorted and deduped in place
+uint64_t graph::bulkFollow(vector<uint64_t>& keys, unsigned threads) {
+    return addEdges(keys, threads);
+}
 
-        vertices.insert(new user(username, first_name, last_name));  // Insert each user into the AVL tree
-        usernames[i] = username;  // Store the username in the array for index reference
+// Add the follows packed in keys as (follower << 32) | followed; keys is sorted and deduped in place
+uint64_t graph::addEdges(vector<uint64_t>& keys, unsigned threads) {
+    STAT_TIME(statAddEdges);
+    uint32_t n = (uint32_t)numUsrs;
+    thaw();
+
+    // Drop self-follows and unknown IDs, then group by follower (and within that by followed) with a radix sort
+    keys.erase(remove_if(keys.begin(), keys.end(), [n](uint64_t k) {
+        uint32_t u = (uint32_t)(k >> 32), v = (uint32_t)k;
+        return u == v || u >= n || v >= n;
+    }), keys.end());
+    radixSort(keys, threads);
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    if (numCncts) {  // Skip follows that are already there (O(1) each through the membership index)
+        keys.erase(remove_if(keys.begin(), keys.end(), [this](uint64_t k) {
+            return users[k >> 32]->following->contains((uint32_t)k);
+        }), keys.end());
     }
 
-    file.close();  // Close the file after reading
+    // Group the followers of each user with a counting sort; sources go in increasing order
+    vector<uint64_t> inStart(n + 1, 0);
+    for (uint64_t k : keys) inStart[(uint32_t)k + 1]++;
+    for (uint32_t v = 0; v < n; v++) inStart[v + 1] += inStart[v];
+    vector<uint32_t> bySource(keys.size());
+    vector<uint64_t> fill(inStart.begin(), inStart.end() - 1);
+    for (uint64_t k : keys) bySource[fill[(uint32_t)k]++] = (uint32_t)(k >> 32);
 
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> distr(0, numUsrs - 1);
+    // One pass over each grouping appends every list's new users at once
+    // Every list belongs to one user, so threads take disjoint ranges of users (cut where the edges split evenly),
+    // each with its own node pool for the arena to absorb afterwards
+    const size_t minSlice = 1 << 16;  // Don't start a thread for fewer edges than this
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<size_t>(1, min<size_t>(threads, keys.size() / minSlice));
+    vector<uint32_t> cut(threads + 1, n), inCut(threads + 1, n);  // Thread t fills following lists cut[t] ... cut[t + 1] - 1, and likewise followers lists by inCut
+    cut[0] = inCut[0] = 0;
+    for (unsigned t = 1; t < threads; t++) {
+        cut[t] = (uint32_t)(keys[keys.size() / threads * t] >> 32);
+        inCut[t] = (uint32_t)(upper_bound(inStart.begin(), inStart.end(), keys.size() / threads * t) - inStart.begin() - 1);
+    }
+    vector<memPool<aNode>> pools(threads);
 
-    int randnum1, randnum2;
-    numCncts = 0;
+    auto append = [&](unsigned t) {
+        vector<uint32_t> batch;
+        size_t i = lower_bound(keys.begin(), keys.end(), (uint64_t)cut[t] << 32) - keys.begin();
+        while (i < keys.size() && (uint32_t)(keys[i] >> 32) < cut[t + 1]) {
+            uint32_t u = (uint32_t)(keys[i] >> 32);
+            batch.clear();
+            for (; i < keys.size() && (uint32_t)(keys[i] >> 32) == u; i++) batch.push_back((uint32_t)keys[i]);
+            users[u]->following->addBatch(batch.data(), (int)batch.size(), &pools[t]);
+            users[u]->numFollowing += (int)batch.size();
+        }
+        for (uint32_t v = inCut[t]; v < inCut[t + 1]; v++) {
+            if (inStart[v] == inStart[v + 1]) continue;
+            int len = (int)(inStart[v + 1] - inStart[v]);  // v's followers are already together in bySource
+            users[v]->followers->addBatch(bySource.data() + inStart[v], len, &pools[t]);
+            users[v]->numFollowers += len;
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.push_back(thread(append, t));
+    append(0);
+    for (thread& th : pool) th.join();
+    for (memPool<aNode>& p : pools) mem.nodes.absorb(p);
 
-    // Generate random user connections (follow relationships)
-    for(int i = 0; i < numUsrs * 30; i++) {
-        randnum1 = distr(gen);
-        randnum2 = distr(gen);
-        if(vertices.retrieve(usernames[randnum1])->follow(vertices.retrieve(usernames[randnum2]))) numCncts++;
+    numCncts += (int)keys.size();
+    if (!keys.empty()) {  // Cheaper to rank everyone again than to apply every follow one at a time
+        degrees.reset();
+        reachReady = false;
+        friendCache.clear();
     }
+    return keys.size();
 }
 
-// Destructor to free dynamically allocated memory
-graph::~graph() {
-    delete[] usernames;  // Deallocate memory for the usernames array
+// Load follows from an edge file: one follow per line, follower then followed, separated by a comma or whitespace
+// (any further columns are ignored); byId reads the pair as user IDs, otherwise as usernames
+// The file is split across threads like the user CSV; returns the follows added, or -1 if the file can't be opened
+int64_t graph::loadEdges(const string& path, bool byId, unsigned threads) {
+    STAT_TIME(statLoadEdges);
+    mappedFile file;
+    if (!file.open(path)) return -1;
+
+    vector<const char*> cuts = chunkLines(file, threads);
+    size_t chunks = cuts.size() - 1;
+    vector<vector<uint64_t>> parts(chunks);
+    vector<uint64_t> skipped(chunks, 0);
+
+    auto isSep = [](char c) { return c == ',' || c == ' ' || c == '\t'; };
+    auto parseChunk = [&](size_t t) {
+        parts[t].reserve((cuts[t + 1] - cuts[t]) / 16);
+        forEachLine(cuts[t], cuts[t + 1], [&](const char* first, const char* last) {
+            const char* tok[2];
+            const char* tokEnd[2];
+            const char* p = first;
+            for (int f = 0; f < 2; f++) {  // Find the first two fields
+                while (p < last && isSep(*p)) p++;
+                tok[f] = p;
+                while (p < last && !isSep(*p)) p++;
+                tokEnd[f] = p;
+            }
+
+            uint32_t ids[2];
+            bool ok = true;
+            for (int f = 0; f < 2 && ok; f++) {
+                if (tok[f] == tokEnd[f]) ok = false;
+                else if (byId) {
+                    uint64_t id = 0;
+                    for (const char* c = tok[f]; ok && c < tokEnd[f]; c++) {
+                        ok = *c >= '0' && *c <= '9';
+                        id = id * 10 + (*c - '0');
+                        ok = ok && id < (uint64_t)numUsrs;
+                    }
+                    ids[f] = (uint32_t)id;
+                } else {
+                    user* usr = vertices.retrieve(string(tok[f], tokEnd[f] - tok[f]));
+                    ok = usr != nullptr;
+                    if (ok) ids[f] = usr->id;
+                }
+            }
+            if (ok) parts[t].push_back((uint64_t)ids[0] << 32 | ids[1]);
+            else skipped[t]++;
+        });
+    };
+
+    vector<thread> pool;
+    for (size_t t = 1; t < chunks; t++) pool.push_back(thread(parseChunk, t));
+    parseChunk(0);
+    for (thread& th : pool) th.join();
+
+    // Join the chunks (order doesn't matter, the sort regroups everything)
+    vector<uint64_t> keys;
+    uint64_t bad = 0;
+    for (size_t t = 0; t < chunks; t++) bad += skipped[t];
+    keys.swap(parts[0]);
+    for (size_t t = 1; t < chunks; t++) {
+        keys.insert(keys.end(), parts[t].begin(), parts[t].end());
+        vector<uint64_t>().swap(parts[t]);
+    }
+    if (bad) std::cerr << "Skipped " << bad << " edge lines with unknown users in " << path << std::endl;
+
+    return (int64_t)addEdges(keys, threads);
 }
 
-// Retrieve a user by their index in the usernames array
-user* graph::getUser(int index) {
-    if (index < 0 || index >= numUsrs) return nullptr;  // Return nullptr if the index is out of bounds
-    return vertices.retrieve(usernames[index]);         // Retrieve user from the AVL tree by username
+// Replace the network with a synthetic one (see generator.h); the same parameters always give the same network
+void graph::generate(const genParams& params) {
+    STAT_TIME(statGenerate);
+    clear();
+    numUsrs = (int)params.users;
+    users = new user*[numUsrs];
+    for (uint32_t id = 0; id < params.users; id++) {
+        users[id] = mem.users.make(id, genField(params, id, 0), genField(params, id, 1), genField(params, id, 2), &mem);
+    }
+    vertices.bulkLoad(users, numUsrs, true);  // Zero-padded usernames are already in ID order
+
+    vector<uint64_t> keys;
+    generateEdges(params, keys);
+    addEdges(keys, params.threads);
 }
 
-// Define a structure to store user suggestions and their frequency
-struct UserSuggestion {
-    user* usr;
-    int count;
+// Fill the adjacency lists of a network loaded from a snapshot (see thaw)
+void graph::buildLists() {
+    if (!listsPending) return;
+    listsPending = false;
+    STAT_TIME(statBuildLists);
 
-    // Comparator for sorting suggestions by count in descending order
-    bool operator<(const UserSuggestion& other) const {
-        return count > other.count;
+    for (int i = 0; i < numUsrs; i++) users[i]->numFollowing = users[i]->numFollowers = 0;  // follow() counts them back up
+    for (uint32_t u = 0; u < frozen->numNodes; u++) {
+        for (const uint32_t* v = frozen->outBegin(u); v != frozen->outEnd(u); v++) users[u]->follow(users[*v]);
     }
-};
+}
 
-// Suggest friends for a user based on mutual connections (2nd-degree connections)
-user** graph::suggestFriends(string username, int resultCt) {
-    user* usr = vertices.retrieve(username);  // Retrieve the user by username
-    if (!usr) return nullptr;
+// Read the users from a CSV file (username,firstname,lastname per line); IDs follow the file order
+bool graph::readUsers(const string& path) {
+    STAT_TIME(statLoadCsv);
+    mappedFile file;
+    if (!file.open(path)) {  // Map the CSV file containing user data
+        std::cerr << "Error opening file!" << std::endl;  // Print an error if the file doesn't open
+        return false;
+    }
 
-    unordered_map<user*, int> suggestionFrequency;  // Map to store the frequency of suggested friends
+    // Split the file into rows in one pass (in parallel for big files); the rows point into the mapping
+    vector<csvRow> rows;
+    splitRows(file, rows);
+    numUsrs = (int)rows.size();
 
-    // Get the list of users the current user is following
-    user** followingArr = usr->following->getArr(usr->numFollowing);
-    for (int i = 0; i < usr->numFollowing; i++) {
-        user* friendUsr = followingArr[i];
+    users = new user*[numUsrs];     // Dynamically allocate the array of users
 
-        // Get the friends (following users) of each friend
-        user** friendsOfFriend = friendUsr->following->getArr(friendUsr->numFollowing); 
-        for (int j = 0; j < friendUsr->numFollowing; j++) {
-            user* friendSuggestion = friendsOfFriend[j];
+    // Populate the users array, giving each user the next ID
+    for (int id = 0; id < numUsrs; id++) {
+        users[id] = mem.users.make(id, rows[id].username.str(), rows[id].firstname.str(), rows[id].lastname.str(), &mem);
+    }
 
-            // Ensure the suggestion is not the user itself and not already a follower
-            if (friendSuggestion != usr && !usr->following->view(friendSuggestion->username)) {
-                suggestionFrequency[friendSuggestion]++;  // Increment the suggestion count
-            }
+    loadUsers();  // Bulk-load the users into the AVL tree
+    return true;
+}
+
+// Drop duplicate usernames (the first row wins), renumber the users, and bulk-load the AVL tree in O(n)
+void graph::loadUsers() {
+    vector<user*> sorted(users, users + numUsrs);
+    stable_sort(sorted.begin(), sorted.end(), [](user* a, user* b) { return a->username < b->username; });
+
+    // Within a run of equal usernames, the stable sort leaves the earliest row first
+    vector<bool> dropped(numUsrs, false);
+    size_t kept = 0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (kept && sorted[kept - 1]->username == sorted[i]->username) dropped[sorted[i]->id] = true;
+        else sorted[kept++] = sorted[i];
+    }
+    sorted.resize(kept);
+
+    // Close the gaps left by dropped users so IDs stay dense
+    int id = 0;
+    for (int i = 0; i < numUsrs; i++) {
+        if (dropped[i]) {
+            mem.users.destroy(users[i]);
+            continue;
         }
-        delete[] friendsOfFriend;
+        users[id] = users[i];
+        users[id]->id = id;
+        id++;
+    }
+    numUsrs = id;
+
+    vertices.bulkLoad(sorted.data(), (int)sorted.size(), true);
+}
+
+// Make one user follow another by username
+bool graph::follow(string username1, string username2) {
+    user* usr1 = vertices.retrieve(username1);
+    user* usr2 = vertices.retrieve(username2);
+    return usr1 && usr2 && follow((int)usr1->id, (int)usr2->id);
+}
+
+// Make one user follow another by index; the CSR snapshot is dropped and rebuilt by the next query
+bool graph::follow(int index1, int index2) {
+    STAT_TIME(statFollow);
+    if (index1 < 0 || index1 >= numUsrs || index2 < 0 || index2 >= numUsrs) return false;  // Return false if either index is out of bounds
+    if (index1 == index2 || isFollowing(index1, index2)) return false;  // Nothing would change, so the CSR snapshot stays
+    thaw();
+    users[index1]->follow(users[index2]);
+    numCncts++;
+    if (degrees.ready) degrees.follow(index1, index2);  // O(1) re-rank of both users
+    if (reachReady) updateReach(index1, index2, 1);
+    dropSuggestions(index1);
+    return true;
+}
+
+// Make one user stop following another by username
+bool graph::unfollow(string username1, string username2) {
+    user* usr1 = vertices.retrieve(username1);
+    user* usr2 = vertices.retrieve(username2);
+    return usr1 && usr2 && unfollow((int)usr1->id, (int)usr2->id);
+}
+
+// Make one user stop following another by index; the CSR snapshot is dropped and rebuilt by the next query
+bool graph::unfollow(int index1, int index2) {
+    STAT_TIME(statUnfollow);
+    if (index1 < 0 || index1 >= numUsrs || index2 < 0 || index2 >= numUsrs) return false;  // Return false if either index is out of bounds
+    if (!isFollowing(index1, index2)) return false;  // Wasn't following, so the CSR snapshot stays
+    thaw();
+    users[index1]->unfollow(users[index2]);
+    numCncts--;
+    if (degrees.ready) degrees.unfollow(index1, index2);  // O(1) re-rank of both users
+    if (reachReady) updateReach(index1, index2, -1);
+    dropSuggestions(index1);
+    return true;
+}
+
+// Whether one user follows another, without thawing: a loaded snapshot's lists aren't built yet, so it is asked instead
+bool graph::isFollowing(int follower, int followed) {
+    if (listsPending) return frozen->isFollowing(follower, followed);
+    return users[follower]->following->contains((uint32_t)followed);  // O(1) through the membership index
+}
+
+// Reach (the sum of a user's followers' follower counts) after follower started (sign = 1) or stopped (-1) following followed:
+// followed gains or loses the follower's follower count, and each user that followed follows gains or loses one,
+// O(log users) each whatever the change, so O(degree log users) in all
+void graph::updateReach(int follower, int followed, int sign) {
+    reach.adjust(followed, sign * (int64_t)users[follower]->numFollowers);
+    for (aNode* cur = users[followed]->following->first(); cur; cur = cur->next) reach.adjust(cur->id, sign);
+}
+
+// A user's suggestions depend on who they follow and who those users follow, so a change to follower's following
+// list only affects follower and the users following them; O(followers) and nothing at all while the cache is empty
+void graph::dropSuggestions(int follower) {
+    if (!friendCache.active()) return;
+    friendCache.invalidate(follower);
+    for (aNode* cur = users[follower]->followers->first(); cur; cur = cur->next) friendCache.invalidate(cur->id);
+}
+
+// Remove a user, every follow to or from them, and their place in the vertex index, in O(degree):
+// -each of their edges is unlinked from the other user's list through its membership index in O(1)
+// -IDs must stay dense, so the user with the last ID moves into the freed one, and only the lists holding
+//  that user need the ID in their node changed (rekey)
+// -the CSR snapshot is dropped as for any edge change, and the rankings and suggestion cache (which hold IDs)
+//  are dropped and rebuilt by their next query
+bool graph::removeUser(string username) {
+    STAT_TIME(statRemoveUser);
+    user* usr = vertices.retrieve(username);
+    if (!usr) return false;
+    thaw();
+
+    uint32_t id = usr->id, last = (uint32_t)numUsrs - 1;
+    vertices.remove(username);
+    numCncts -= usr->numFollowing + usr->numFollowers;
+    for (aNode* cur = usr->following->first(); cur; cur = cur->next) {  // Drop them from the followers of everyone they follow
+        users[cur->id]->followers->remove(id);
+        users[cur->id]->numFollowers--;
+    }
+    for (aNode* cur = usr->followers->first(); cur; cur = cur->next) {  // And everyone following them stops
+        users[cur->id]->following->remove(id);
+        users[cur->id]->numFollowing--;
     }
-    delete[] followingArr;
+    mem.users.destroy(usr);  // Frees the lists and their nodes
 
-    // Convert suggestion frequency map to a vector and sort it by frequency
-    vector<UserSuggestion> suggestionList;
-    for (const auto& entry : suggestionFrequency) {
-        suggestionList.push_back({entry.first, entry.second});
+    if (id != last) {  // Renumber the last user into the gap
+        user* moved = users[last];
+        moved->id = id;
+        for (aNode* cur = moved->following->first(); cur; cur = cur->next) users[cur->id]->followers->rekey(last, id);
+        for (aNode* cur = moved->followers->first(); cur; cur = cur->next) users[cur->id]->following->rekey(last, id);
+        users[id] = moved;
     }
-    sort(suggestionList.begin(), suggestionList.end());  // Sort in descending order of frequency
+    users[last] = nullptr;
+    numUsrs--;
+
+    degrees.reset();
+    reach.clear();
+    reachReady = false;
+    friendCache.clear();
+    return true;
+}
+
+// Look a user's index (ID) up by username
+int graph::userIndex(string username) {
+    user* usr = vertices.retrieve(username);
+    return usr ? (int)usr->id : -1;
+}
+
+// Look a username up by index (ID)
+string graph::username(int index) {
+    user* usr = getUser(index);
+    return usr ? usr->username : string();
+}
+
+// Retrieve a user by their index (ID)
+user* graph::getUser(int index) {
+    if (index < 0 || index >= numUsrs) return nullptr;  // Return nullptr if the index is out of bounds
+    return users[index];                                // IDs index the users array directly
+}
+
+// Pack every adjacency list into a CSR snapshot (rows are indexed by user ID)
+const csrGraph& graph::freeze() {
+    if (frozen) return *frozen;  // The snapshot is still current
+    STAT_TIME(statFreeze);
+
+    uint64_t numEdges = 0;
+    for (int i = 0; i < numUsrs; i++) numEdges += users[i]->numFollowing;
+
+    csrGraph* g = new csrGraph(numUsrs, numEdges);
+
+    // Offsets come straight from the follow counts
+    for (int i = 0; i < numUsrs; i++) {
+        g->outOff[i + 1] = g->outOff[i] + users[i]->numFollowing;
+        g->inOff[i + 1] = g->inOff[i] + users[i]->numFollowers;
+    }
+
+    // Copy each following list into its row and sort it
+    for (int i = 0; i < numUsrs; i++) {
+        uint64_t pos = g->outOff[i];
+        for (aNode* cur = users[i]->following->first(); cur; cur = cur->next) g->outAdj[pos++] = cur->id;
+        sort(g->outAdj + g->outOff[i], g->outAdj + pos);
+    }
+
+    // Scatter the out-edges into the follower rows; visiting sources in ID order leaves those rows sorted too
+    vector<uint64_t> fill(g->inOff, g->inOff + g->numNodes);
+    for (uint32_t u = 0; u < g->numNodes; u++) {
+        for (const uint32_t* v = g->outBegin(u); v != g->outEnd(u); v++) g->inAdj[fill[*v]++] = u;
+    }
+
+    frozen = g;
+    return *frozen;
+}
+
+// Suggest friends for a user based on mutual connections (2nd-degree connections)
+// Repeat requests are answered from the suggestion cache until an edge near the user changes
+user** graph::suggestFriends(string username, int resultCt, int* found) {
+    STAT_TIME(statSuggest);
+    if (found) *found = 0;
+    user* usr = vertices.retrieve(username);  // Retrieve the user by username
+    if (!usr) return nullptr;
+    resultCt = min(resultCt, numUsrs);  // There are never more suggestions than users
+
+    vector<uint32_t> ids;
+    if (!friendCache.lookup(usr->id, resultCt, ids)) {
+        // Count the paths through the users they follow with dense counters (see suggest.h); ties go to the lower ID
+        // Right after an edge change the lists are walked directly, rather than rebuilding the whole CSR snapshot for one user
+        ids.resize(max(resultCt, 0));
+        int ct = frozen ? suggester.suggest(*frozen, usr->id, resultCt, ids.data())
+                        : suggester.suggest(numUsrs, usr->id, resultCt, ids.data(), listFollowing(users));
+        ids.resize(ct);
+        friendCache.store(numUsrs, usr->id, resultCt, ids.data(), ct);
+    }
+    int finalCount = (int)ids.size();
+    if (found) *found = finalCount;
 
     // Limit the number of suggestions to `resultCt`
-    int finalCount = min(resultCt, (int)suggestionList.size());
     user** topSuggestions = new user*[finalCount];
     for (int i = 0; i < finalCount; i++) {
-        topSuggestions[i] = suggestionList[i].usr;  // Store top suggestions in the result array
+        topSuggestions[i] = getUser(ids[i]);  // Store top suggestions in the result array
     }
 
     return topSuggestions;
 }
 
-// Retrieve the most connected users based on followers and following count
-user** graph::mostConnected(int resultCt) {
+// Suggest friends for many users at once, spread over `threads` threads (0 = one per core)
+// Row i of suggestions (resultCt slots) holds ids[i]'s suggestions, best first, and found[i] says how many there are
+void graph::suggestFriends(const vector<uint32_t>& ids, int resultCt, vector<uint32_t>& suggestions, vector<int>& found, unsigned threads) {
+    STAT_TIME(statSuggestBatch);
+    if (resultCt < 0) resultCt = 0;
+    suggestions.assign(ids.size() * resultCt, 0);
+    found.assign(ids.size(), 0);
+    suggestBatch(freeze(), ids.data(), ids.size(), resultCt, suggestions.data(), found.data(), threads);
+}
+
+// Suggest friends for every user at once (row i is user i); see the batched suggestFriends
+void graph::suggestFriendsAll(int resultCt, vector<uint32_t>& suggestions, vector<int>& found, unsigned threads) {
+    STAT_TIME(statSuggestBatch);
+    if (resultCt < 0) resultCt = 0;
+    suggestions.assign((size_t)numUsrs * resultCt, 0);
+    found.assign(numUsrs, 0);
+    suggestBatch(freeze(), nullptr, numUsrs, resultCt, suggestions.data(), found.data(), threads);
+}
+
+// Retrieve the most connected users based on followers and following count (or on either one alone)
+// The degree index already has everyone in order, so this reads off the first resultCt users in O(resultCt)
+user** graph::mostConnected(int resultCt, degreeKind by) {
+    STAT_TIME(statConnected);
     if (resultCt > numUsrs) resultCt = numUsrs;  // Ensure the result count does not exceed the total number of users
-    
-    user** mostConnectedUsers = new user*[resultCt];
-    priority_queue<pair<int, user*>> pq;
+    if (resultCt < 0) resultCt = 0;
 
-    // Add users to a priority queue based on the sum of followers and following
-    for (int i = 0; i < numUsrs; i++) {
-        user* usr = getUser(i);
-        pq.push(make_pair(usr->numFollowers + usr->numFollowing, usr));  // Sum of followers and following
+    if (!degrees.ready) {  // First query since a load or bulk follow: rank everyone, O(users + max degree)
+        degrees.build(numUsrs, [this](uint32_t id) { return users[id]->numFollowers; }, [this](uint32_t id) { return users[id]->numFollowing; });
     }
 
-    // Extract the top `resultCt` users from the priority queue
-    for (int i = 0; i < resultCt && !pq.empty(); i++) {
-        mostConnectedUsers[i] = pq.top().second;
-        pq.pop();  // Pop the user with the highest sum of followers and following
-    }
+    const uint32_t* top = degrees.ranks[by].top();
+    user** mostConnectedUsers = new user*[resultCt];
+    for (int i = 0; i < resultCt; i++) mostConnectedUsers[i] = users[top[i]];
 
     return mostConnectedUsers;
 }
 
-// Calculate the most influential users based on their followers' followers
+// Calculate the most influential users based on PageRank
 user** graph::mostInfluential(int resultCt) {
+    STAT_TIME(statInfluential);
     if (resultCt > numUsrs) resultCt = numUsrs;  // Ensure the result count does not exceed the total number of users
-    
+    if (resultCt < 0) resultCt = 0;
+
+    vector<double> rank;
+    pageRank(rank);
+
+    // Keep the top `resultCt` users based on rank
+    vector<uint32_t> top = topIds(rank.data(), (uint32_t)rank.size(), resultCt);
     user** mostInfluentialUsers = new user*[resultCt];
-    priority_queue<pair<int, user*>> pq;
+    for (int i = 0; i < resultCt; i++) mostInfluentialUsers[i] = getUser(top[i]);
 
-    // Calculate the influence score for each user by summing their followers' followers
-    for (int i = 0; i < numUsrs; i++) {
-        user* usr = getUser(i);
-        int influenceScore = 0;
+    return mostInfluentialUsers;
+}
 
-        // Get all followers and calculate their influence (followers' followers)
-        user** followersArr = usr->followers->getArr(usr->numFollowers);
-        for (int j = 0; j < usr->numFollowers; j++) {
-            user* follower = followersArr[j];
-            influenceScore += follower->numFollowers;  // Add number of followers of this follower
-        }
-        pq.push(make_pair(influenceScore, usr));  // Push user with their influence score into the queue
-        delete[] followersArr;
-    }
+// Find the bridge users: exact betweenness for small networks, sampled for large ones
+user** graph::mostBetween(int resultCt) {
+    STAT_TIME(statBridges);
+    if (resultCt > numUsrs) resultCt = numUsrs;  // Ensure the result count does not exceed the total number of users
+    if (resultCt < 0) resultCt = 0;
+
+    const double epsilon = 0.05;  // Error bound used once the network is too large for exact mode
+    vector<double> bc;
+    betweenness(bc, numUsrs <= maxExactBetweenness ? 0 : epsilon);
+
+    // Keep the top `resultCt` users based on betweenness
+    vector<uint32_t> top = topIds(bc.data(), (uint32_t)bc.size(), resultCt);
+    user** mostBetweenUsers = new user*[resultCt];
+    for (int i = 0; i < resultCt; i++) mostBetweenUsers[i] = getUser(top[i]);
+
+    return mostBetweenUsers;
+}
+
+// Calculate the users with the most reach, scoring each by summing their followers' followers
+// The scores are ranked once and then kept up to date by follow/unfollow (see updateReach), so this is O(resultCt)
+user** graph::mostReaching(int resultCt) {
+    STAT_TIME(statReaching);
+    if (resultCt > numUsrs) resultCt = numUsrs;  // Ensure the result count does not exceed the total number of users
+    if (resultCt < 0) resultCt = 0;
 
-    // Extract the top `resultCt` users based on influence score
-    for (int i = 0; i < resultCt && !pq.empty(); i++) {
-        mostInfluentialUsers[i] = pq.top().second;
-        pq.pop();  // Pop the user with the highest influence score
+    if (!reachReady) {  // First query since a load or bulk follow: score and rank everyone over the CSR snapshot
+        const csrGraph& g = freeze();
+        reach.build(g.numNodes, [&g](uint32_t v) {
+            uint64_t score = 0;  // At most the number of follows, so it fits a scoreRank
+            for (const uint32_t* f = g.inBegin(v); f != g.inEnd(v); f++) score += g.inDeg(*f);
+            return score;
+        });
+        reachReady = true;
     }
 
-    return mostInfluentialUsers;
+    vector<uint32_t> top = reach.top(resultCt);
+    user** mostReachingUsers = new user*[resultCt];
+    for (int i = 0; i < resultCt; i++) mostReachingUsers[i] = users[top[i]];
+
+    return mostReachingUsers;
 }
 
 // Calculate degree of separation between two users by username
+// Returns the number of follow hops from username1 to username2, or -1 if either user doesn't exist or there is no path
 int graph::sepDegree(string username1, string username2) {
+    STAT_TIME(statSep);
     user* usr1 = vertices.retrieve(username1);
     user* usr2 = vertices.retrieve(username2);
 
     if (!usr1 || !usr2) return -1;  // Return -1 if either user doesn't exist
 
-    // BFS or DFS could be used here to calculate the separation degree
-    // We will use a simple placeholder method (You could replace it with real BFS/DFS)
-
-    return 2;  // Placeholder value, indicating the degree of separation
+    const csrGraph& g = freeze();
+    uint32_t d = bfs.distance(g, usr1->id, usr2->id);  // Bidirectional BFS over the snapshot
+    return d == bfsEngine::NONE ? -1 : (int)d;
 }
 
 // Overload of `sepDegree` to find separation by index
 int graph::sepDegree(int index1, int index2) {
-    return sepDegree(usernames[index1], usernames[index2]);
+    STAT_TIME(statSep);
+    if (index1 < 0 || index1 >= numUsrs || index2 < 0 || index2 >= numUsrs) return -1;  // Return -1 if either index is out of bounds
+
+    const csrGraph& g = freeze();
+    uint32_t d = bfs.distance(g, index1, index2);  // IDs are the indices, so no lookups are needed
+    return d == bfsEngine::NONE ? -1 : (int)d;
+}
+
+// Overload of `sepDegree` that also fills `path` with the users along one shortest path
+int graph::sepDegree(string username1, string username2, vector<user*>& path) {
+    STAT_TIME(statSep);
+    path.clear();
+    user* usr1 = vertices.retrieve(username1);
+    user* usr2 = vertices.retrieve(username2);
+
+    if (!usr1 || !usr2) return -1;  // Return -1 if either user doesn't exist
+
+    const csrGraph& g = freeze();
+    vector<uint32_t> idPath;
+    uint32_t d = bfs.path(g, usr1->id, usr2->id, idPath);
+    if (d == bfsEngine::NONE) return -1;
+
+    for (uint32_t id : idPath) path.push_back(getUser(id));  // Translate IDs back to users
+    return (int)d;
+}
+
+// Batched overload of `sepDegree`: answers all n pairs with bit-parallel BFS sweeps of up to 64 sources each
+void graph::sepDegree(const int* index1, const int* index2, int* degrees, int n) {
+    STAT_TIME(statSepBatch);
+    const csrGraph& g = freeze();
+
+    // Keep only the pairs with valid indices
+    vector<uint32_t> src, dst, dist;
+    vector<int> slot;
+    for (int k = 0; k < n; k++) {
+        degrees[k] = -1;
+        if (index1[k] < 0 || index1[k] >= numUsrs || index2[k] < 0 || index2[k] >= numUsrs) continue;
+        src.push_back(index1[k]);
+        dst.push_back(index2[k]);
+        slot.push_back(k);
+    }
+
+    dist.resize(src.size());
+    multiBfs.distances(g, src.data(), dst.data(), dist.data(), src.size());
+    for (size_t k = 0; k < slot.size(); k++) {
+        degrees[slot[k]] = dist[k] == msBfs::NONE ? -1 : (int)dist[k];
+    }
+}
+
+// Separation from each of n sources to every user, with bit-parallel BFS sweeps of up to 64 sources each:
+// row k of degrees (usrCt() entries) holds sources[k]'s distances, -1 where there is no path or sources[k] isn't a valid index
+void graph::distancesFrom(const int* sources, int n, int* degrees) {
+    STAT_TIME(statDistancesFrom);
+    const csrGraph& g = freeze();
+    fill(degrees, degrees + (size_t)n * numUsrs, -1);
+
+    // Keep only the valid sources
+    vector<uint32_t> src, dist;
+    vector<int> slot;
+    for (int k = 0; k < n; k++) {
+        if (sources[k] < 0 || sources[k] >= numUsrs) continue;
+        src.push_back(sources[k]);
+        slot.push_back(k);
+    }
+
+    dist.resize(src.size() * numUsrs);
+    multiBfs.distancesFrom(g, src.data(), src.size(), dist.data());
+    for (size_t k = 0; k < slot.size(); k++) {
+        const uint32_t* row = dist.data() + k * numUsrs;
+        int* out = degrees + (size_t)slot[k] * numUsrs;
+        for (int i = 0; i < numUsrs; i++) out[i] = row[i] == msBfs::NONE ? -1 : (int)row[i];
+    }
+}
+
+// Count the ordered pairs of users at each distance (hist[0] counts each user with itself) and find the diameter
+// Unreachable pairs are not counted, and the diameter is the longest finite distance
+bool graph::distanceHistogram(vector<uint64_t>& hist, int* diameter) {
+    STAT_TIME(statDistances);
+    if (numUsrs > maxAllPairs) return false;  // All-pairs costs about numUsrs / 64 full sweeps
+
+    *diameter = (int)multiBfs.histogram(freeze(), hist);
+    return true;
+}
+
+// Rank users with PageRank over the follow graph: damping is the chance of following another edge,
+// and iteration stops once the total (L1) change in rank falls below tolerance
+int graph::pageRank(vector<double>& rank, double damping, double tolerance, unsigned threads) {
+    STAT_TIME(statPageRank);
+    const int maxIter = 200;  // Give up on convergence after this many iterations
+    return ::pageRank(freeze(), rank, damping, tolerance, maxIter, threads);
+}
+
+// Betweenness centrality of every user: how many shortest follow paths between other users pass through them
+// epsilon = 0 runs every user as a source (exact); otherwise enough random pivots are sampled that each normalized
+// score is within epsilon of exact with probability 1 - failProb
+int graph::betweenness(vector<double>& bc, double epsilon, double failProb, uint64_t seed) {
+    STAT_TIME(statBetweenness);
+    const csrGraph& g = freeze();
+    if (epsilon <= 0) {
+        betweennessExact(g, bc, 0);
+        return numUsrs;
+    }
+
+    uint32_t k = betweennessPivots(g.numNodes, epsilon, failProb);
+    betweennessSampled(g, bc, k, seed, 0);
+    return (int)k;
+}
+
+// Split the network into strongly connected components (groups where everyone can reach everyone by following)
+int graph::stronglyConnected(vector<uint32_t>& compOf, vector<uint32_t>& sizes) {
+    STAT_TIME(statScc);
+    return (int)findScc(freeze(), compOf, sizes);
 }
 
 // Print all users and their connections (for debugging purposes)
@@ -263,8 +1008,9 @@ void graph::print() {
 
 // Print friend suggestions for a given user by username
 void graph::printFriendSuggestions(string username, int resultCt) {
-    user** suggestions = suggestFriends(username, resultCt);
-    for (int i = 0; suggestions && i < resultCt; i++) {
+    int found;
+    user** suggestions = suggestFriends(username, resultCt, &found);
+    for (int i = 0; i < found; i++) {
         cout << suggestions[i]->username << endl;
     }
     delete[] suggestions;
@@ -272,25 +1018,86 @@ void graph::printFriendSuggestions(string username, int resultCt) {
 
 // Overloaded method to print friend suggestions for a user by index
 void graph::printFriendSuggestions(int index, int resultCt) {
-    printFriendSuggestions(usernames[index], resultCt);
+    printFriendSuggestions(users[index]->username, resultCt);
 }
 
 // Print the degree of separation between two users (by username)
 void graph::printSeparationDegree(string username1, string username2) {
-    int degree = sepDegree(username1, username2);
-    cout << "Degree of separation between " << username1 << " and " << username2 << ": " << degree << endl;
+    vector<user*> path;
+    int degree = sepDegree(username1, username2, path);
+    cout << "Degree of separation between " << username1 << " and " << username2 << ": ";
+    if (degree < 0) {
+        cout << "not connected" << endl;
+        return;
+    }
+    cout << degree << " (";
+    for (size_t i = 0; i < path.size(); i++) {
+        cout << (i ? " -> " : "") << path[i]->username;  // Print the path that was found
+    }
+    cout << ")" << endl;
 }
 
 // Overloaded method to print separation degree by index
 void graph::printSeparationDegree(int index1, int index2) {
-    printSeparationDegree(usernames[index1], usernames[index2]);
+    printSeparationDegree(users[index1]->username, users[index2]->username);
+}
+
+// Print a batch of separation degrees by index
+void graph::printSeparationDegrees(const int* index1, const int* index2, int n) {
+    vector<int> degrees(n);
+    sepDegree(index1, index2, degrees.data(), n);
+    for (int k = 0; k < n; k++) {
+        cout << "Degree of separation between " << users[index1[k]]->username << " and " << users[index2[k]]->username << ": ";
+        if (degrees[k] < 0) cout << "not connected" << endl;
+        else cout << degrees[k] << endl;
+    }
+}
+
+// Print how many ordered pairs of users are each distance apart, plus the diameter
+void graph::printDistanceStats() {
+    vector<uint64_t> hist;
+    int diameter;
+    if (!distanceHistogram(hist, &diameter)) {
+        cout << "Network too large for all-pairs distances (" << numUsrs << " users, limit " << maxAllPairs << ")" << endl;
+        return;
+    }
+
+    uint64_t reachable = 0;
+    for (size_t d = 1; d < hist.size(); d++) {
+        cout << "Pairs " << d << " apart: " << hist[d] << endl;
+        reachable += hist[d];
+    }
+    cout << "Unreachable pairs: " << (uint64_t)numUsrs * (numUsrs - 1) - reachable << endl;
+    cout << "Diameter: " << diameter << endl;
+}
+
+// Print the largest strongly connected components with a sample of their members
+void graph::printTopComponents(int resultCt) {
+    const int shown = 10;  // Members listed per component
+    vector<uint32_t> compOf, sizes;
+    int ct = stronglyConnected(compOf, sizes);
+    cout << "Strongly connected components: " << ct << endl;
+
+    vector<uint32_t> top = topIds(sizes.data(), ct, resultCt);
+    for (size_t i = 0; i < top.size(); i++) {
+        cout << "Component " << i + 1 << " (" << sizes[top[i]] << " users): ";
+        int listed = 0;
+        for (int v = 0; v < numUsrs && listed < shown; v++) {
+            if (compOf[v] != top[i]) continue;
+            cout << (listed ? ", " : "") << users[v]->username;
+            listed++;
+        }
+        if (sizes[top[i]] > (uint32_t)shown) cout << ", ...";
+        cout << endl;
+    }
 }
 
 // Print the most connected users
 void graph::printMostConnectedUser(int resultCt) {
     user** connectedUsers = mostConnected(resultCt);
     cout << "Most Connected Users: " << endl;
-    for (int i = 0; i < resultCt; i++) {
+    int shown = max(0, min(resultCt, numUsrs));  // The array only holds this many
+    for (int i = 0; i < shown; i++) {
         cout << connectedUsers[i]->username << endl;
     }
     delete[] connectedUsers;
@@ -300,12 +1107,35 @@ void graph::printMostConnectedUser(int resultCt) {
 void graph::printMostInfluentialUser(int resultCt) {
     user** influentialUsers = mostInfluential(resultCt);
     cout << "Most Influential Users: " << endl;
-    for (int i = 0; i < resultCt; i++) {
+    int shown = max(0, min(resultCt, numUsrs));  // The array only holds this many
+    for (int i = 0; i < shown; i++) {
         cout << influentialUsers[i]->username << endl;
     }
     delete[] influentialUsers;
 }
 
+// Print the users with the most reach
+void graph::printMostReachingUser(int resultCt) {
+    user** reachingUsers = mostReaching(resultCt);
+    cout << "Users With the Most Reach: " << endl;
+    int shown = max(0, min(resultCt, numUsrs));  // The array only holds this many
+    for (int i = 0; i < shown; i++) {
+        cout << reachingUsers[i]->username << endl;
+    }
+    delete[] reachingUsers;
+}
+
+// Print the bridge users (highest betweenness centrality)
+void graph::printBridgeUsers(int resultCt) {
+    user** bridgeUsers = mostBetween(resultCt);
+    cout << "Bridge Users: " << endl;
+    int shown = max(0, min(resultCt, numUsrs));  // The array only holds this many
+    for (int i = 0; i < shown; i++) {
+        cout << bridgeUsers[i]->username << endl;
+    }
+    delete[] bridgeUsers;
+}
+
 // Print the total number of users in the graph
 void graph::printNumberOfUsers() {
     cout << "Total number of users: " << numUsrs << endl;
@@ -316,14 +1146,60 @@ void graph::printAverageNumberOfConnections() {
     cout << "Average number of connections: " << (float)numCncts / numUsrs << endl;
 }
 
+// Print how many objects each pool holds and what the same objects would have cost allocated one by one
+void graph::printMemoryStats() {
+    printPoolStats("Users", mem.users);
+    printPoolStats("Adjacency lists", mem.lists);
+    printPoolStats("Adjacency list nodes", mem.nodes);
+}
+
+// Return how many suggestFriends calls were answered from the suggestion cache
+uint64_t graph::suggestCacheHits() {
+    return friendCache.hits();
+}
+
+// Return how many suggestFriends calls had to compute their suggestions
+uint64_t graph::suggestCacheMisses() {
+    return friendCache.misses();
+}
+
+// Print the network's sizes and every instrumentation stat recorded so far (see stats.h), as text or as one JSON object
+// Without GRAPH_STATS only the sizes are printed, plus a note that the stats were compiled out
+void graph::dumpStats(bool json, ostream& out) {
+    if (json) {
+        out << "{\"enabled\": " << (statsEnabled ? "true" : "false") << ", \"users\": " << numUsrs << ", \"follows\": " << numCncts
+            << ", \"frozen\": " << (frozen ? "true" : "false") << ", \"suggestCacheHits\": " << friendCache.hits()
+            << ", \"suggestCacheMisses\": " << friendCache.misses() << ", \"stats\": {";
+        statDump(out, true);
+        out << "}}" << endl;
+        return;
+    }
+
+    out << "Users: " << numUsrs << ", follows: " << numCncts << ", CSR snapshot: " << (frozen ? "built" : "not built") << endl;
+    out << "Suggestion cache: " << friendCache.hits() << " hits, " << friendCache.misses() << " misses" << endl;
+    if (!statsEnabled) {
+        out << "Instrumentation is compiled out (build with -DGRAPH_STATS, or make STATS=1)" << endl;
+        return;
+    }
+    statDump(out, false);
+}
+
 //Return the total number of users
 int graph::usrCt() {
     return numUsrs;
 }
 
+//Return the total number of follows
+int graph::followCt() {
+    return numCncts;
+}
+
 //Return the average connections per user
 int graph::avgConnectionCT() {
     return numCncts / numUsrs;
 }
 
+const int graph::maxAllPairs;
+const int graph::maxExactBetweenness;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+/*
+Vertex index benchmark:
+-Compares the three vertex indexes from vertexIndex.h (AVL, B+-tree, flat hash map)
+-For each network size it times, per index:
+    -bulk load of every user
+    -one-at-a-time inserts in random order
+    -lookups of random existing usernames (hits) and of usernames that are not there (misses)
+    -removes of every user in random order
+-Sizes come from the command line (default: 10000 1000000 10000000)
+-Build: make indexBench (or g++ -std=c++11 -O2 -o indexBench indexBench.cpp)
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include "adjList.h"
+#include "avl.h"
+#include "btree.h"
+#include "flatMap.h"
+using namespace std;
+
+// Seconds since start
+double since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Print one result row as millions of operations per second
+void report(const string& index, const string& op, size_t ops, double secs) {
+    cout << left << setw(10) << index << setw(10) << op << right << setw(12) << fixed << setprecision(2) << ops / secs / 1e6 << " Mops/s" << endl;
+}
+
+// Time every operation on one index type
+template <typename T>
+void benchIndex(const string& name, vector<user*>& users, vector<string>& misses, mt19937& gen) {
+    size_t n = users.size();
+    size_t lookups = max<size_t>(n, 1000000);  // Enough lookups for a stable number on small networks
+    size_t found = 0;  // Keeps the lookups from being optimized away
+
+    // Bulk load (from random order, so every index pays for the same sort)
+    shuffle(users.begin(), users.end(), gen);
+    {
+        auto start = chrono::steady_clock::now();
+        T index;
+        index.bulkLoad(users.data(), (int)n);
+        report(name, "bulk", n, since(start));
+    }
+
+    // One-at-a-time inserts in random order
+    T index;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) index.insert(users[i]);
+    report(name, "insert", n, since(start));
+
+    // Lookups of existing usernames
+    uniform_int_distribution<size_t> pick(0, n - 1);
+    vector<size_t> order(lookups);
+    for (size_t i = 0; i < lookups; i++) order[i] = pick(gen);
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) found += index.retrieve(users[order[i]]->username) != nullptr;
+    report(name, "hit", lookups, since(start));
+
+    // Lookups of missing usernames
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) found += index.retrieve(misses[order[i]]) != nullptr;
+    report(name, "miss", lookups, since(start));
+
+    // Removes in random order
+    shuffle(users.begin(), users.end(), gen);
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) index.remove(users[i]->username);
+    report(name, "remove", n, since(start));
+
+    if (found != lookups) cout << "WARNING: " << found << " of " << lookups << " hits found" << endl;
+}
+
+int main(int argc, char** argv) {
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(strtoull(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {10000, 1000000, 10000000};
+
+    mt19937 gen(12345);  // Fixed seed so runs are comparable
+    for (size_t n : sizes) {
+        // Unique usernames that share a long common prefix, like the CSV's (name + digits); misses use a different suffix
+        vector<user*> users(n);
+        vector<string> misses(n);
+        for (size_t i = 0; i < n; i++) {
+            users[i] = new user((uint32_t)i, "user" + to_string(i) + "x", "", "");
+            misses[i] = "user" + to_string(i) + "y";
+        }
+
+        cout << "USERS: " << n << endl;
+        benchIndex<AVL>("avl", users, misses, gen);
+        benchIndex<bTree>("btree", users, misses, gen);
+        benchIndex<flatMap>("flat", users, misses, gen);
+        cout << endl;
+
+        for (user* usr : users) delete usr;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef _INGEST_H_
+#define _INGEST_H_
+
+/*
+Follow ingestion:
+-Several producer threads stage follows at once, and compact() later adds them all to the graph in one bulk pass
+-Each producer appends to its own buffer, so staging a follow is a plain vector push: no lock, no compare-and-swap,
+    and no cache line shared with another producer (the buffers are padded apart)
+-Buffers hold packed edge keys, (follower << 32) | followed, the same as bulkFollow's, so compact() just
+    concatenates them and hands them to the graph's bulk path: a parallel radix sort, dedupe, a skip of
+    follows that already exist, and the list appends, split over threads by user
+-Nothing is kept per user while staging: degrees only change in compact(), once repeats and follows that
+    already exist have been dropped
+-Follows by unknown IDs and self-follows are dropped when staged
+-compact() must not overlap staging: join or pause the producers first; the graph must not gain or lose users
+    while follows are staged
+*/
+
+#include <cstdint>
+#include <vector>
+#include "graph.h"
+#include "stats.h"
+using namespace std;
+
+class followIngest {
+private:
+    struct stagingBuffer {
+        vector<uint64_t> keys;     // One producer's staged follows
+        char pad[64];              // Keeps the next producer's vector off this one's cache line
+    };
+
+    graph& g;                      // Where compact() adds the follows
+    uint32_t n;                    // Users in the graph
+    vector<stagingBuffer> buffers; // One per producer
+
+public:
+    followIngest(graph& target, unsigned producers);
+
+    // Stage a follow; call from one thread per producer index (different producers may run at the same time)
+    void follow(unsigned producer, uint32_t follower, uint32_t followed);
+    uint64_t staged() const;       // Follows staged since the last compaction (only exact while no one is staging)
+    uint64_t compact(unsigned threads = 0);  // Add every staged follow to the graph on `threads` threads (0 = one per core); returns how many were new
+};
+
+followIngest::followIngest(graph& target, unsigned producers)
+    : g(target), n((uint32_t)target.usrCt()), buffers(max(1u, producers)) {}
+
+void followIngest::follow(unsigned producer, uint32_t follower, uint32_t followed) {
+    if (follower >= n || followed >= n || follower == followed) return;
+    buffers[producer].keys.push_back((uint64_t)follower << 32 | followed);
+}
+
+uint64_t followIngest::staged() const {
+    uint64_t total = 0;
+    for (const stagingBuffer& b : buffers) total += b.keys.size();
+    return total;
+}
+
+uint64_t followIngest::compact(unsigned threads) {
+    STAT_TIME(statIngestCompact);
+    vector<uint64_t> keys;
+    keys.reserve(staged());
+    for (stagingBuffer& b : buffers) {
+        keys.insert(keys.end(), b.keys.begin(), b.keys.end());
+        vector<uint64_t>().swap(b.keys);
+    }
+    return g.bulkFollow(keys, threads);
+}
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef _LIVEGRAPH_H_
+#define _LIVEGRAPH_H_
+
+/*
+Live graph:
+-One writer thread applies batches of follows and unfollows while any number of reader threads run separation,
+    friend suggestion and most connected queries, and neither side ever waits for the other
+-Readers only see immutable versions (graphVersion): a paged CSR snapshot (see pagedCsr.h), the degree rankings and an epoch
+-The writer never touches a published version: apply() builds the next one beside it (pagedCsr::withEdits) and
+    publishes it with a single atomic pointer store, RCU style
+-Versions are copy-on-write: the next version shares every page of rows and of rankings the batch leaves alone, and
+    only the pages holding a changed row or a moved ranking entry are copied, so publishing costs
+    O(the touched pages' rows and edges + users / 65536) rather than a copy of the whole network
+-Versions are shared_ptrs, so an old version lives on while any reader still holds it and is freed by
+    whichever thread lets go of it last; the writer never waits for readers to drain
+-A reader pins the newest version (liveReader::pin) and runs any number of queries against it, so a run of
+    queries sees one consistent network; pinning again picks up whatever has been published since
+-Each liveReader has its own BFS and suggestion scratch space, so readers share nothing mutable
+-Follows never change usernames, so every version shares one name table
+-Within a batch the last event for an edge wins; follows that already exist, unfollows of missing edges,
+    self-follows and unknown IDs are skipped
+-Every publish still allocates a version and copies a few pages, so the writer should gather events into
+    batches (hundreds or thousands per apply) rather than publish each one
+-A live graph starts from a graph's current state and then evolves on its own; the graph itself is left alone
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "csr.h"
+#include "pagedCsr.h"
+#include "bfs.h"
+#include "suggest.h"
+#include "degreeIndex.h"
+#include "stats.h"
+#include "graph.h"
+using namespace std;
+
+struct followEvent {
+    uint32_t follower;             // Who follows or unfollows
+    uint32_t followed;             // Whom
+    bool follow;                   // Follow (true) or unfollow (false)
+
+    followEvent(uint32_t u = 0, uint32_t v = 0, bool f = true) : follower(u), followed(v), follow(f) {}
+};
+
+struct userNames {
+    vector<string> byId;           // Username of each ID
+    vector<uint32_t> sorted;       // IDs in username order, for lookups
+
+    int find(const string& username) const;  // ID of a username (-1 if there is none)
+};
+
+int userNames::find(const string& username) const {
+    auto it = lower_bound(sorted.begin(), sorted.end(), username,
+                          [this](uint32_t id, const string& name) { return byId[id] < name; });
+    return it != sorted.end() && byId[*it] == username ? (int)*it : -1;
+}
+
+struct graphVersion {
+    static const uint32_t rankPageBits = 8;  // 256 IDs per page of a ranking
+
+    uint64_t epoch;                // Batches published before this one (0 = the starting state)
+    const pagedCsr* edges;         // The follows, frozen
+    shared_ptr<const userNames> names;  // Shared by every version
+    pageTable<vector<uint32_t>> ranked[3];  // User IDs by degree, highest first, one ranking per degreeKind, in pages
+
+    graphVersion(uint64_t e, const pagedCsr* g, const shared_ptr<const userNames>& n) : epoch(e), edges(g), names(n) {}
+    ~graphVersion() { delete edges; }
+
+    uint32_t rankedAt(degreeKind by, uint32_t i) const { return ranked[by].page(i >> rankPageBits)[i & ((1u << rankPageBits) - 1)]; }  // The ith ID of a ranking
+
+private:
+    graphVersion(const graphVersion&);  // Versions are shared by pointer, never copied
+    graphVersion& operator=(const graphVersion&);
+};
+
+const uint32_t graphVersion::rankPageBits;
+
+class liveGraph {
+private:
+    shared_ptr<const graphVersion> current;  // Newest published version (only ever loaded and stored atomically)
+    shared_ptr<const graphVersion> head;     // The writer's own reference to the same version
+    degreeIndex degrees;           // Rankings the writer keeps up to date; each version gets copies of the pages that changed
+
+    void copyRanks(graphVersion& next, int kind, uint32_t page);  // Copy one page of a ranking from degrees into next
+    void publish(graphVersion* next);  // Make next the newest version
+
+public:
+    explicit liveGraph(graph& g);  // Start from g's users and follows (g is frozen, not otherwise changed)
+
+    // Writer only (one thread at a time): apply a batch and publish it as the next version; returns the edges changed
+    uint64_t apply(const vector<followEvent>& events);
+    shared_ptr<const graphVersion> latest() const;  // Any thread: the newest published version
+};
+
+liveGraph::liveGraph(graph& g) {
+    const csrGraph& frozen = g.freeze();
+    userNames* names = new userNames;
+    names->byId.resize(frozen.numNodes);
+    names->sorted.resize(frozen.numNodes);
+    for (uint32_t id = 0; id < frozen.numNodes; id++) {
+        names->byId[id] = g.username(id);
+        names->sorted[id] = id;
+    }
+    sort(names->sorted.begin(), names->sorted.end(), [names](uint32_t a, uint32_t b) { return names->byId[a] < names->byId[b]; });
+
+    degrees.build(frozen.numNodes, [&](uint32_t id) { return frozen.inDeg(id); }, [&](uint32_t id) { return frozen.outDeg(id); });
+    graphVersion* first = new graphVersion(0, new pagedCsr(frozen), shared_ptr<const userNames>(names));
+    uint32_t pages = (frozen.numNodes + (1u << graphVersion::rankPageBits) - 1) >> graphVersion::rankPageBits;
+    for (int k = 0; k < 3; k++) {
+        first->ranked[k].resize(pages);
+        for (uint32_t i = 0; i < pages; i++) copyRanks(*first, k, i);
+    }
+    publish(first);
+}
+
+void liveGraph::copyRanks(graphVersion& next, int kind, uint32_t page) {
+    const degreeRank& r = degrees.ranks[kind];
+    uint32_t first = page << graphVersion::rankPageBits, last = min(r.size(), first + (1u << graphVersion::rankPageBits));
+    next.ranked[kind].set(page, make_shared<const vector<uint32_t>>(r.top() + first, r.top() + last));
+}
+
+void liveGraph::publish(graphVersion* next) {
+    head.reset(next);
+    atomic_store(&current, head);  // Readers that pin from here on get the new version
+}
+
+shared_ptr<const graphVersion> liveGraph::latest() const {
+    return atomic_load(&current);
+}
+
+uint64_t liveGraph::apply(const vector<followEvent>& events) {
+    STAT_TIME(statLiveApply);
+    const graphVersion& cur = *head;
+    const pagedCsr& g = *cur.edges;
+
+    // Sort the events by edge, keeping their order within an edge, so the last event for each edge decides it
+    vector<pair<uint64_t, uint32_t>> byEdge;
+    byEdge.reserve(events.size());
+    for (uint32_t i = 0; i < events.size(); i++) {
+        const followEvent& e = events[i];
+        if (e.follower >= g.numNodes || e.followed >= g.numNodes || e.follower == e.followed) continue;
+        byEdge.push_back(make_pair((uint64_t)e.follower << 32 | e.followed, i));
+    }
+    sort(byEdge.begin(), byEdge.end());
+
+    // A re-rank swaps the moving user with one other, so every ranking entry an edge change moves held u or v
+    // just before or just after it; those entries' pages are the ones the next version needs copies of
+    vector<uint32_t> moved[3];
+    auto touch = [&](uint32_t u, uint32_t v) {
+        for (int k = 0; k < 3; k++) {
+            moved[k].push_back(degrees.ranks[k].rankOf(u) >> graphVersion::rankPageBits);
+            moved[k].push_back(degrees.ranks[k].rankOf(v) >> graphVersion::rankPageBits);
+        }
+    };
+
+    vector<uint64_t> adds, drops;  // Stay sorted, since byEdge is
+    for (size_t i = 0; i < byEdge.size(); i++) {
+        if (i + 1 < byEdge.size() && byEdge[i + 1].first == byEdge[i].first) continue;  // A later event decides this edge
+        uint64_t k = byEdge[i].first;
+        uint32_t u = (uint32_t)(k >> 32), v = (uint32_t)k;
+        bool following = g.isFollowing(u, v);
+        if (events[byEdge[i].second].follow && !following) {
+            adds.push_back(k);
+            touch(u, v);
+            degrees.follow(u, v);
+            touch(u, v);
+        } else if (!events[byEdge[i].second].follow && following) {
+            drops.push_back(k);
+            touch(u, v);
+            degrees.unfollow(u, v);
+            touch(u, v);
+        }
+    }
+    if (adds.empty() && drops.empty()) return 0;  // Nothing changed, so the current version stands
+
+    // The next version shares every page of cur that the batch left alone
+    graphVersion* next = new graphVersion(cur.epoch + 1, g.withEdits(adds, drops), cur.names);
+    for (int k = 0; k < 3; k++) {
+        next->ranked[k] = cur.ranked[k];
+        sort(moved[k].begin(), moved[k].end());
+        moved[k].erase(unique(moved[k].begin(), moved[k].end()), moved[k].end());
+        for (uint32_t page : moved[k]) copyRanks(*next, k, page);
+    }
+    publish(next);
+    return adds.size() + drops.size();
+}
+
+class liveReader {
+private:
+    const liveGraph& live;
+    shared_ptr<const graphVersion> pinned;  // The version queries run against
+    bfsEngine bfs;                 // This reader's scratch space for separation queries
+    suggestEngine suggester;       // And for friend suggestions
+
+public:
+    explicit liveReader(const liveGraph& g) : live(g), pinned(g.latest()) {}
+
+    uint64_t pin();                // Move on to the newest version; returns its epoch
+    const graphVersion& version() const { return *pinned; }
+
+    int userIndex(const string& username) const { return pinned->names->find(username); }  // -1 if there is none
+    const string& username(uint32_t id) const { return pinned->names->byId[id]; }
+    int sepDegree(uint32_t index1, uint32_t index2);  // Follow hops from index1 to index2 (-1 if unreachable or unknown)
+    int suggestFriends(uint32_t index, int resultCt, uint32_t* out);  // Fill out with up to resultCt suggestions, best first; returns how many
+    vector<uint32_t> mostConnected(int resultCt, degreeKind by = degreeTotal) const;  // IDs of the highest degree users, highest first
+};
+
+uint64_t liveReader::pin() {
+    pinned = live.latest();
+    return pinned->epoch;
+}
+
+int liveReader::sepDegree(uint32_t index1, uint32_t index2) {
+    const pagedCsr& g = *pinned->edges;
+    if (index1 >= g.numNodes || index2 >= g.numNodes) return -1;
+    uint32_t d = bfs.distance(g, index1, index2);
+    return d == bfsEngine::NONE ? -1 : (int)d;
+}
+
+int liveReader::suggestFriends(uint32_t index, int resultCt, uint32_t* out) {
+    const pagedCsr& g = *pinned->edges;
+    return suggester.suggest(g.numNodes, index, resultCt, out, pagedFollowing(g));
+}
+
+vector<uint32_t> liveReader::mostConnected(int resultCt, degreeKind by) const {
+    vector<uint32_t> ids(min<size_t>(max(resultCt, 0), pinned->edges->numNodes));
+    for (uint32_t i = 0; i < ids.size(); i++) ids[i] = pinned->rankedAt(by, i);
+    return ids;
+}
+
+#endif
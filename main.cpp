@@ -17,17 +17,51 @@ NOTE:
 Dataset: Generate your own with 250 nodes.
 
 Graph:
--AVL tree of all nodes
+-AVL tree of all nodes (or another vertex index picked at compile time, see vertexIndex.h)
 -Nodes store all edges
 -Edges store nodes
--AVL tree performs memory management
--String array to allow for indexing of users
+-A memory arena of slab pools (see pool.h and adjList.h) performs memory management for users, lists and edges
+-Users are numbered with dense IDs (0 ... numUsrs - 1); an array of users by ID allows for indexing of users
+-Each username is stored once, in its user; string lookups go through the AVL tree and everything else uses IDs
 -Integers to store total number of users and total number of connections
 -Methods added to allow for computations
+-user_data.csv is memory-mapped and split in place in a single pass (see csvLoader.h)
+-freeze() packs the edges into a CSR snapshot (see csr.h) that the analytics run against
+-Follows are added in bulk (bulkFollow, loadEdges): the batch is grouped and deduped with a radix sort,
+    then every following and followers list gets its new users in one pass, split over threads by user
+-Many threads can stage follows at once through a followIngest (see ingest.h): each appends to its own
+    buffer with no locks, and compact() dedupes and adds the lot through bulkFollow
+-follow/unfollow change single edges; the CSR snapshot is dropped and rebuilt by the next query
+    (only when an edge really changes: a repeated follow or a missing unfollow leaves it alone)
+-removeUser takes a user out in O(degree): their edges are unlinked through the lists' membership indexes,
+    and the user with the last ID moves into the freed one so IDs stay dense
+-The destructor is O(users + edges): users give back their strings and indexes, then the arena and the
+    vertex index drop their slabs whole, with no edge unlinked one at a time
+-Users are also kept ranked by degree (see degreeIndex.h): follow/unfollow re-rank the two users in O(1),
+    so mostConnected reads the top users straight off the ranking
+-Friend suggestions count friends of friends with dense per-thread counters (see suggest.h), and can be
+    made for every user at once on all cores (suggestFriendsAll)
+-Each user's last suggestions are cached; follow/unfollow drop only the entries of the follower and their followers,
+    the only users whose friends of friends changed
+-Reach (followers' followers) is ranked too, in an ordered set (see degreeIndex.h): a follow changes the followed user's
+    reach by the follower's follower count and everyone they follow by one, so mostReaching is O(k) and
+    follow/unfollow O(degree log users)
+-A liveGraph (see liveGraph.h) serves queries from many threads while one writer applies batches of follows:
+    readers run against immutable CSR versions that the writer publishes with an atomic pointer swap; versions are
+    paged (see pagedCsr.h) and share every page a batch leaves alone, so a publish copies only the touched rows' pages
+-main -serve keeps a loaded network in memory and answers pipelined commands (suggest, sep, top-connected, ...)
+    from stdin or a Unix socket (see server.h)
+-Synthetic networks of any size come from the seeded generator (see generator.h), either into a graph (generate)
+    or straight into a snapshot file (generateSnapshot)
+-saveSnapshot()/loadSnapshot() write and memory-map a binary image of the network (see snapshot.h)
+-Building with GRAPH_STATS times every load, edge change and query, and dumpStats() prints the timings
+    together with the AVL and adjacency list lookup costs (see stats.h)
 
 User:
 -Must have a unique username
+-Has a dense ID (0, 1, 2, ...) assigned by the graph when it is loaded; everything internal keys on the ID
 -Members:
+    -id (uint32_t)
     -username (string)
     -firstname (string)
     -lastname (string)
@@ -35,29 +69,23 @@ User:
     -numFollowers (int)
     -following (adjList)
     -followers (adjList)
+    -mem (memArena*) (the graph's pools, or nullptr for a user made on its own)
 -Methods:
     -follow (user*) - follows user and adds self to the other person's followers
-    -unfollow (string) - unfollows user and removes self from other person's followers
+    -unfollow (user*) - unfollows user and removes self from other person's followers
 -Whenever someone is followed or unfollowed, his numFollowers is adjusted
 -Whenever someone follows or unfollows, his numFollowing is adjusted
 -The graph should deal primarily with users rather than adjLists because each user's adjList is a member of it.
 -The constructor creates the adjacency list for the member.
 
+Memory arena:
+-A graph owns one memArena: slab pools (see pool.h) for its users, their adjLists and every aNode
+-Users made with an arena take their lists and nodes from its pools; users made without one fall back to new/delete
+-When the graph goes away it releases whole slabs at once instead of deleting every node
+
 Adjacency list:
--List of users that someone is following
--Head stores the person himself
--All users in list are stored as pointers so that they will be updated when changed elsewhere in graph
--Each following node represents someone connected to head
--Since a user can add, remove, and view connections, here are the methods:
-    -Add (bool) (bool to see whether it happened)
-    -Remove (bool) (bool to see whether it happened)
-    -View (user*) (* to allow for use of actual user)
--Users can also view their own profiles, adding this method:
-    -Self (user*) (* to allow for use of actual user)
--Additionally, it is important to use the list quickly for connections without knowledge of names
-    As a result, the following method is needed:
-    -getArr (user**) (This ptr has a dynamic array. Be sure to delete it!)
--Finally, a constructor and destructor are needed.
+-List of users that someone is following, one 32-bit user ID per node
+-Its methods, membership index and ID-only lookups are described at the top of adjList.h (kept in that one place only)
 
 Note on organization of adjList.h:
 In order to work around difficulties with circular dependencies, user needed to be forward declared.
@@ -71,6 +99,12 @@ AVL:
 -Used for graph to have easy access to each adjacency list and user
 -Very normal AVL tree
 -Stores users as pointers
+-Insert, remove and retrieve are iterative and descend the tree once:
+    -The descent records the link (parent's child pointer) to every node it passes
+    -Insert and remove then walk those links back up, fixing heights and rotating where needed
+-A whole batch of users can be bulk-loaded in O(n): the sorted batch is split at its middle recursively,
+    which gives a perfectly balanced tree with no rotations
+-Tree nodes come from the tree's own slab pool, so destroying the tree frees a few slabs
 
 
 
@@ -78,13 +112,79 @@ THE QUESTION:
 When deleting a node, how insure no one is still following the non-user?
 */
 #include <iostream>
+#include <memory>
+#include <cstring>
 #include "adjList.h"
 #include "avl.h"
 #include "graph.h"
+#include "server.h"
 using namespace std;
 
-int main() {
-    graph socialNetwork;  // Create an instance of the 'graph' class, which represents the social network
+// Usage: main [-load snapshot | -edges file | -edgeids file | -gen model] [-users n] [-follows m] [-seed s] [-save snapshot] [-gensnap snapshot] [-stats text|json] [-serve stdin|socket]
+//   -load opens a saved network instead of building one from user_data.csv with random follows
+//   -edges / -edgeids keep the users from user_data.csv but take the follows from an edge file of username / ID pairs
+//   -gen makes a synthetic network (model: uniform, ba, rmat or chunglu) of n users (at least 2) and about m follows from seed s
+//   -gensnap writes the synthetic network straight to a snapshot file and exits (no analysis)
+//   -save writes the network out, so later runs (and other processes) can map it instead
+//   -serve skips the report and answers commands (see server.h) from stdin, or from clients of a Unix socket at the given path
+//   -stats ends the report with the instrumentation stats (build with make STATS=1 to collect them), as a table or as JSON
+int main(int argc, char** argv) {
+    string loadPath, savePath, edgePath, genModelName, genSnapPath, statsFormat, servePath;
+    bool edgeIds = false;
+    genParams params(genUniform, 10000, 300000, 1);
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-load")) loadPath = argv[i + 1];
+        else if (!strcmp(argv[i], "-save")) savePath = argv[i + 1];
+        else if (!strcmp(argv[i], "-gen")) genModelName = argv[i + 1];
+        else if (!strcmp(argv[i], "-gensnap")) genSnapPath = argv[i + 1];
+        else if (!strcmp(argv[i], "-stats")) statsFormat = argv[i + 1];
+        else if (!strcmp(argv[i], "-serve")) servePath = argv[i + 1];
+        else if (!strcmp(argv[i], "-users")) params.users = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "-follows")) params.follows = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "-seed")) params.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "-edges") || !strcmp(argv[i], "-edgeids")) {
+            edgePath = argv[i + 1];
+            edgeIds = !strcmp(argv[i], "-edgeids");
+        }
+    }
+
+    if (!genModelName.empty() && !parseGenModel(genModelName, params.model)) {
+        cerr << "Unknown model " << genModelName << " (use uniform, ba, rmat or chunglu)" << endl;
+        return 1;
+    }
+    if (params.users < 2) {
+        cerr << "-users must be at least 2" << endl;
+        return 1;
+    }
+    if (!statsFormat.empty() && statsFormat != "text" && statsFormat != "json") {
+        cerr << "Unknown stats format " << statsFormat << " (use text or json)" << endl;
+        return 1;
+    }
+    if (!genSnapPath.empty()) {  // Generate straight to a snapshot file and stop
+        int64_t written = generateSnapshot(params, genSnapPath);
+        if (written < 0) {
+            cerr << "Error saving snapshot " << genSnapPath << "!" << endl;
+            return 1;
+        }
+        cout << "Wrote " << params.users << " users and " << written << " follows to " << genSnapPath << endl;
+        return 0;
+    }
+
+    unique_ptr<graph> network;
+    if (!loadPath.empty()) network.reset(new graph(loadPath));
+    else if (!genModelName.empty()) network.reset(new graph(params));
+    else if (!edgePath.empty()) network.reset(new graph("user_data.csv", edgePath, edgeIds));
+    else network.reset(new graph());
+    graph& socialNetwork = *network;  // The 'graph' instance that represents the social network
+
+    if (!savePath.empty() && !socialNetwork.saveSnapshot(savePath)) cerr << "Error saving snapshot " << savePath << "!" << endl;
+
+    if (!servePath.empty()) {  // Answer commands instead of printing the report
+        graphServer server(socialNetwork);
+        socialNetwork.freeze();  // Build the CSR snapshot now, so the first query doesn't pay for it
+        cerr << "Serving " << socialNetwork.usrCt() << " users on " << servePath << endl;
+        return servePath == "stdin" ? server.serveStream(0, 1) : server.serveSocket(servePath);
+    }
 
     cout << "NETWORK USER INFO:" << endl;
     socialNetwork.print();  // Print all the users and their connections in the network
@@ -100,32 +200,59 @@ int main() {
     cout << endl;
 
     cout << "5 MOST INFLUENTIAL USERS:" << endl;
-    socialNetwork.printMostInfluentialUser(5);  // Print the top 5 most influential users based on followers' followers
+    socialNetwork.printMostInfluentialUser(5);  // Print the top 5 most influential users based on PageRank
+    cout << endl;
+
+    cout << "5 BRIDGE USERS:" << endl;
+    socialNetwork.printBridgeUsers(5);  // Print the top 5 users based on betweenness centrality
+    cout << endl;
+
+    cout << "5 USERS WITH THE MOST REACH:" << endl;
+    socialNetwork.printMostReachingUser(5);  // Print the top 5 users based on followers' followers
+    cout << endl;
+
+    cout << "5 LARGEST STRONGLY CONNECTED COMPONENTS:" << endl;
+    socialNetwork.printTopComponents(5);  // Print the 5 largest groups of users who can all reach each other
     cout << endl;
 
     cout << "FRIEND SUGGESTIONS: (Emily Rodriguez)" << endl;
     socialNetwork.printFriendSuggestions("emilyrodriguez859", 5);  // Print 5 friend suggestions for the user "emilyrodriguez859"
     cout << endl;
 
-    random_device rd;  // Seed for the random number generator
-    mt19937 gen(rd());  // Initialize the random number generator (Mersenne Twister)
+    if (socialNetwork.usrCt() >= 2) {  // A distinct pair needs two users (a loaded snapshot or CSV may have fewer)
+        random_device rd;  // Seed for the random number generator
+        mt19937 gen(rd());  // Initialize the random number generator (Mersenne Twister)
 
-    uniform_int_distribution<> distr(0, socialNetwork.usrCt() - 1);  // Define the distribution for selecting random user indices
+        uniform_int_distribution<> distr(0, socialNetwork.usrCt() - 1);  // Define the distribution for selecting random user indices
 
-    int randnum1, randnum2;
+        int index1[5], index2[5];
 
-    cout << "DEGREE OF SEPARATION (5 sets of users)" << endl;
-    // Run the loop to print 5 random degrees of separation between pairs of users
-    for(int i = 0; i < 5; i++){
-        randnum1 = distr(gen);  // Generate a random number for the first user
-        randnum2 = distr(gen);  // Generate a random number for the second user
+        cout << "DEGREE OF SEPARATION (5 sets of users)" << endl;
+        // Pick 5 random pairs of distinct users and answer them as one batch
+        for(int i = 0; i < 5; i++){
+            index1[i] = distr(gen);  // Generate a random number for the first user
+            index2[i] = distr(gen);  // Generate a random number for the second user
 
-        if(randnum1 != randnum2)  // Ensure the two random users are not the same
-            socialNetwork.printSeparationDegree(randnum1, randnum2);  // Print the degree of separation between the two users
-        else
-            i--;  // If the same user is selected, decrement the counter to repeat the iteration
+            if(index1[i] == index2[i])  // Ensure the two random users are not the same
+                i--;  // If the same user is selected, decrement the counter to repeat the iteration
+        }
+        socialNetwork.printSeparationDegrees(index1, index2, 5);  // Print the degree of separation between each pair
+        cout << endl;
     }
+
+    cout << "DISTANCE DISTRIBUTION:" << endl;
+    socialNetwork.printDistanceStats();  // Print how far apart all pairs of users are, and the network's diameter
+    cout << endl;
+
+    cout << "MEMORY USAGE:" << endl;
+    socialNetwork.printMemoryStats();  // Print how many objects the memory pools hold and what they saved
     cout << endl;
 
+    if (!statsFormat.empty()) {
+        cout << "INSTRUMENTATION:" << endl;
+        socialNetwork.dumpStats(statsFormat == "json");  // Print where the time went
+        cout << endl;
+    }
+
     return 0;  // Return 0 to indicate that the program executed successfully
 }
@@ -0,0 +1,211 @@
+#ifndef _MSBFS_H_
+#define _MSBFS_H_
+
+/*
+MS-BFS:
+-Multi-source BFS that runs up to 64 searches at once over a CSR snapshot (see csr.h)
+-Each vertex keeps one 64-bit word per state, with bit i belonging to source i:
+    -seen: which searches have already reached the vertex
+    -visit: which searches have the vertex in their current frontier
+    -next: which searches reach the vertex in the next level
+-One sweep over the frontier advances all 64 searches by a level, so
+    64 separation queries (or 64 rows of an all-pairs table) cost about one BFS
+-The vertices each level activates are also kept in a list: a level walks that list while the frontier is small,
+    and scans every vertex's word in order only once it covers a sizable share of the network; clearing up after
+    a sweep goes through the same lists, so a search that stays local never touches the whole network
+-Used for batched sepDegree queries, for distances from a set of sources to everyone (distancesFrom)
+    and for the all-pairs distance histogram / diameter
+*/
+
+#include <cstdint>
+#include <vector>
+#include <bitset>
+#include <algorithm>
+#include "csr.h"
+using namespace std;
+
+class msBfs {
+private:
+    vector<uint64_t> seen;         // Searches that have reached each vertex
+    vector<uint64_t> visit;        // Searches with each vertex in the current frontier
+    vector<uint64_t> next;         // Searches with each vertex in the next frontier
+    vector<uint32_t> touched;      // Every vertex activated during the sweep, level by level (the frontier lists)
+    vector<uint32_t> tgtStamp;     // Batch in which each vertex was last used as a target
+    vector<uint32_t> tgtHead;      // First pair (in the current batch) whose target is this vertex
+    uint32_t batchNo;              // Stamp of the current batch of pairs
+
+    static const uint32_t denseShare = 16;  // A level scans every vertex once its frontier holds more than 1/denseShare of them
+
+    void prepare(uint32_t n);      // Size the arrays for n vertices (all zero between sweeps)
+
+    // Advance up to 64 searches level by level, calling onReach(vertex, newBits, level) whenever
+    // searches reach a vertex for the first time; stops early once onReach returns false
+    template <typename F>
+    void sweep(const csrGraph& g, const uint32_t* src, int cnt, F onReach);
+
+public:
+    static const uint32_t NONE = UINT32_MAX;  // Distance reported for unreachable targets
+    static const int WIDTH = 64;              // Searches per sweep (bits per word)
+
+    msBfs();
+
+    // Fill out[k] with the number of follow hops from src[k] to dst[k] (NONE if unreachable)
+    void distances(const csrGraph& g, const uint32_t* src, const uint32_t* dst, uint32_t* out, size_t n);
+    // Fill out[k * numNodes + v] with the number of follow hops from src[k] to every user v (NONE if unreachable)
+    void distancesFrom(const csrGraph& g, const uint32_t* src, size_t n, uint32_t* out);
+    // Count ordered pairs at each distance (hist[d] = pairs d hops apart, hist[0] = the users themselves) and return the diameter
+    uint32_t histogram(const csrGraph& g, vector<uint64_t>& hist);
+};
+
+const uint32_t msBfs::NONE;
+const int msBfs::WIDTH;
+const uint32_t msBfs::denseShare;
+
+msBfs::msBfs() : batchNo(0) {}
+
+void msBfs::prepare(uint32_t n) {
+    if (seen.size() == n) return;
+    seen.assign(n, 0);
+    visit.assign(n, 0);
+    next.assign(n, 0);
+    tgtStamp.assign(n, 0);
+    tgtHead.assign(n, NONE);
+    batchNo = 0;
+}
+
+template <typename F>
+void msBfs::sweep(const csrGraph& g, const uint32_t* src, int cnt, F onReach) {
+    touched.clear();
+    bool active = true;
+    for (int i = 0; i < cnt; i++) {  // Level 0: each source reaches itself
+        uint64_t bit = uint64_t(1) << i;
+        if (!visit[src[i]]) touched.push_back(src[i]);
+        seen[src[i]] |= bit;
+        visit[src[i]] |= bit;
+        if (!onReach(src[i], bit, 0)) active = false;
+    }
+
+    // Push v's frontier bits to the users it follows; false once onReach asks to stop
+    auto expand = [&](uint32_t v, uint32_t level) {
+        uint64_t frontier = visit[v];
+        for (const uint32_t* w = g.outBegin(v); w != g.outEnd(v); w++) {
+            uint64_t fresh = frontier & ~seen[*w];  // Searches reaching w for the first time
+            if (!fresh) continue;
+            if (!next[*w]) touched.push_back(*w);  // Joins the next frontier's list
+            seen[*w] |= fresh;
+            next[*w] |= fresh;
+            if (!onReach(*w, fresh, level)) return false;
+        }
+        return true;
+    };
+
+    size_t lo = 0, hi = touched.size();  // The current frontier is touched[lo, hi)
+    for (uint32_t level = 1; active; level++) {
+        if (hi - lo > g.numNodes / denseShare) {  // Large frontier: an in-order scan reads the words sequentially
+            for (uint32_t v = 0; v < g.numNodes && active; v++) {
+                if (visit[v]) active = expand(v, level);
+            }
+        } else {
+            for (size_t i = lo; i < hi && active; i++) active = expand(touched[i], level);
+        }
+        if (touched.size() == hi) break;  // Every search has run out of frontier
+
+        for (size_t i = lo; i < hi; i++) visit[touched[i]] = 0;
+        visit.swap(next);  // next is all zero again
+        lo = hi;
+        hi = touched.size();
+    }
+
+    for (uint32_t v : touched) seen[v] = visit[v] = next[v] = 0;  // Leave every word clean for the next sweep
+}
+
+void msBfs::distances(const csrGraph& g, const uint32_t* src, const uint32_t* dst, uint32_t* out, size_t n) {
+    prepare(g.numNodes);
+
+    // Visit the pairs grouped by source so each batch holds up to 64 distinct sources
+    vector<uint32_t> order(n);
+    for (size_t k = 0; k < n; k++) {
+        order[k] = (uint32_t)k;
+        out[k] = NONE;
+    }
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return src[a] < src[b]; });
+
+    vector<uint32_t> sources;          // Distinct sources of the current batch
+    vector<uint64_t> pairBit(n);       // Source bit of each pair in the current batch
+    vector<uint32_t> pairNext(n);      // Next pair sharing the same target
+
+    size_t k = 0;
+    while (k < n) {
+        // Gather up to 64 distinct sources and link each of their pairs into its target's list
+        if (++batchNo == 0) {
+            fill(tgtStamp.begin(), tgtStamp.end(), 0);
+            batchNo = 1;
+        }
+        sources.clear();
+        size_t pending = 0;
+        for (; k < n; k++) {
+            uint32_t p = order[k];
+            if (sources.empty() || sources.back() != src[p]) {
+                if ((int)sources.size() == WIDTH) break;
+                sources.push_back(src[p]);
+            }
+            pairBit[p] = uint64_t(1) << (sources.size() - 1);
+            if (tgtStamp[dst[p]] != batchNo) {
+                tgtStamp[dst[p]] = batchNo;
+                tgtHead[dst[p]] = NONE;
+            }
+            pairNext[p] = tgtHead[dst[p]];
+            tgtHead[dst[p]] = p;
+            pending++;
+        }
+
+        // Answer pairs as their targets are reached and stop as soon as all of them are answered
+        sweep(g, sources.data(), (int)sources.size(), [&](uint32_t v, uint64_t bits, uint32_t level) {
+            if (tgtStamp[v] != batchNo) return true;
+            for (uint32_t p = tgtHead[v]; p != NONE; p = pairNext[p]) {
+                if ((bits & pairBit[p]) && out[p] == NONE) {
+                    out[p] = level;
+                    pending--;
+                }
+            }
+            return pending > 0;
+        });
+    }
+}
+
+void msBfs::distancesFrom(const csrGraph& g, const uint32_t* src, size_t n, uint32_t* out) {
+    prepare(g.numNodes);
+    fill(out, out + n * g.numNodes, NONE);
+
+    // Up to 64 sources per sweep; each search writes its own row as it reaches users
+    for (size_t first = 0; first < n; first += WIDTH) {
+        int cnt = (int)min<size_t>(WIDTH, n - first);
+        uint32_t* rows = out + first * g.numNodes;
+        sweep(g, src + first, cnt, [&](uint32_t v, uint64_t bits, uint32_t level) {
+            for (; bits; bits &= bits - 1) rows[(size_t)__builtin_ctzll(bits) * g.numNodes + v] = level;
+            return true;
+        });
+    }
+}
+
+uint32_t msBfs::histogram(const csrGraph& g, vector<uint64_t>& hist) {
+    prepare(g.numNodes);
+    hist.assign(1, 0);
+
+    vector<uint32_t> sources;
+    for (uint32_t first = 0; first < g.numNodes; first += WIDTH) {
+        sources.clear();
+        for (uint32_t s = first; s < g.numNodes && s < first + WIDTH; s++) sources.push_back(s);
+
+        sweep(g, sources.data(), (int)sources.size(), [&](uint32_t, uint64_t bits, uint32_t level) {
+            if (level >= hist.size()) hist.resize(level + 1, 0);
+            hist[level] += bitset<64>(bits).count();  // One new pair per search that arrived
+            return true;
+        });
+    }
+
+    while (hist.size() > 1 && !hist.back()) hist.pop_back();
+    return (uint32_t)hist.size() - 1;  // The longest finite distance
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef _PAGEDCSR_H_
+#define _PAGEDCSR_H_
+
+/*
+Paged CSR:
+-A CSR snapshot (see csr.h) cut into pages of 64 users' rows, one set of pages per direction, so that successive
+    versions of the network share every page a batch of edits leaves alone (copy-on-write, see liveGraph.h)
+-A page holds its users' rows back to back with local offsets; once built it is never written again, and it is
+    shared through shared_ptr, so it lives exactly as long as some version still uses it
+-Pages are reached through a two-level pageTable: directories of 1024 pages, and the list of directories
+    -Copying a table copies only the list of directories (one per 65536 users for a CSR)
+    -Replacing a page copies its directory first, unless this table already has its own copy
+-withEdits() makes the next version with a batch of edges added and removed: each touched page is rebuilt once with
+    all of its edits merged in, so it costs O(users / 65536 + the touched pages' rows and edges), however large the network
+-Rows stay sorted by ID, and the accessors match csrGraph's (outBegin, outDeg, isFollowing, ...), so the BFS engine runs
+    on either; pagedFollowing gives the suggestion engine the out-rows
+-pageTable works for any page type: liveGraph also pages its degree rankings with it
+*/
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "csr.h"
+using namespace std;
+
+// Two-level table of shared, immutable pages; a copy shares every directory and page until set() replaces one
+template <typename P>
+class pageTable {
+private:
+    static const uint32_t dirBits = 10;  // 1024 pages per directory
+    typedef vector<shared_ptr<const P>> pageDir;
+    vector<shared_ptr<pageDir>> dirs;  // Directory d holds pages d << dirBits ...
+
+public:
+    void resize(uint32_t pages) { dirs.resize((pages + (1u << dirBits) - 1) >> dirBits); }  // Room for that many pages (all empty until set)
+    const P& page(uint32_t i) const { return *(*dirs[i >> dirBits])[i & ((1u << dirBits) - 1)]; }
+
+    // Replace page i (only while no reader can see this table yet)
+    // A directory shared with another table is copied first; the writer's previous version still holds every
+    // directory this table was copied from, so a use count of one means the directory is this table's own copy
+    void set(uint32_t i, shared_ptr<const P> p) {
+        shared_ptr<pageDir>& d = dirs[i >> dirBits];
+        if (!d) d = make_shared<pageDir>(1u << dirBits);
+        else if (d.use_count() > 1) d = make_shared<pageDir>(*d);
+        (*d)[i & ((1u << dirBits) - 1)] = move(p);
+    }
+};
+
+template <typename P>
+const uint32_t pageTable<P>::dirBits;
+
+struct csrPage {  // The rows of 64 consecutive users (fewer in the last page)
+    vector<uint32_t> off;          // Row r is adj[off[r]] ... adj[off[r + 1] - 1]
+    vector<uint32_t> adj;          // The rows back to back
+};
+
+class pagedCsr {
+private:
+    static const uint32_t pageBits = 6;  // 64 rows per page
+    static const uint32_t rowMask = (1u << pageBits) - 1;  // Row of a user within its page
+    pageTable<csrPage> out;        // Who each user is following
+    pageTable<csrPage> in;         // Who each user is followed by
+
+    static shared_ptr<const csrPage> rowsOf(const csrGraph& g, uint32_t first, uint32_t last, bool outgoing);  // Page of rows first ... last - 1
+    void editPages(pageTable<csrPage>& table, const vector<uint64_t>& adds, const vector<uint64_t>& drops) const;  // Rebuild the pages the (row << 32 | ID) edits touch
+
+public:
+    uint32_t numNodes;             // Number of users (IDs run from 0 to numNodes - 1)
+    uint64_t numEdges;             // Number of follow edges
+
+    explicit pagedCsr(const csrGraph& g);  // Page every row of a snapshot
+
+    const uint32_t* outBegin(uint32_t v) const { const csrPage& p = out.page(v >> pageBits); return p.adj.data() + p.off[v & rowMask]; }
+    const uint32_t* outEnd(uint32_t v) const { const csrPage& p = out.page(v >> pageBits); return p.adj.data() + p.off[(v & rowMask) + 1]; }
+    uint32_t outDeg(uint32_t v) const { const csrPage& p = out.page(v >> pageBits); return p.off[(v & rowMask) + 1] - p.off[v & rowMask]; }
+
+    const uint32_t* inBegin(uint32_t v) const { const csrPage& p = in.page(v >> pageBits); return p.adj.data() + p.off[v & rowMask]; }
+    const uint32_t* inEnd(uint32_t v) const { const csrPage& p = in.page(v >> pageBits); return p.adj.data() + p.off[(v & rowMask) + 1]; }
+    uint32_t inDeg(uint32_t v) const { const csrPage& p = in.page(v >> pageBits); return p.off[(v & rowMask) + 1] - p.off[v & rowMask]; }
+
+    bool isFollowing(uint32_t u, uint32_t v) const { return binary_search(outBegin(u), outEnd(u), v); }
+
+    // The next version: this one with some edges added and some removed, both given as sorted packed keys
+    // (every added edge must be new and every removed one present); this version is only read
+    pagedCsr* withEdits(const vector<uint64_t>& adds, const vector<uint64_t>& drops) const;
+};
+
+struct pagedFollowing {  // forFollowing over a paged CSR's out-rows (see suggest.h)
+    const pagedCsr& g;
+    pagedFollowing(const pagedCsr& graph) : g(graph) {}
+    template <typename V>
+    void operator()(uint32_t x, V visit) const {
+        for (const uint32_t* y = g.outBegin(x), *end = g.outEnd(x); y != end; y++) visit(*y);
+    }
+};
+
+const uint32_t pagedCsr::pageBits;
+const uint32_t pagedCsr::rowMask;
+
+shared_ptr<const csrPage> pagedCsr::rowsOf(const csrGraph& g, uint32_t first, uint32_t last, bool outgoing) {
+    shared_ptr<csrPage> p = make_shared<csrPage>();
+    p->off.reserve(last - first + 1);
+    p->adj.reserve((outgoing ? g.outOff : g.inOff)[last] - (outgoing ? g.outOff : g.inOff)[first]);
+    p->off.push_back(0);
+    for (uint32_t v = first; v < last; v++) {
+        const uint32_t* b = outgoing ? g.outBegin(v) : g.inBegin(v);
+        const uint32_t* e = outgoing ? g.outEnd(v) : g.inEnd(v);
+        p->adj.insert(p->adj.end(), b, e);
+        p->off.push_back((uint32_t)p->adj.size());
+    }
+    return p;
+}
+
+pagedCsr::pagedCsr(const csrGraph& g) : numNodes(g.numNodes), numEdges(g.numEdges) {
+    uint32_t pages = (numNodes + (1u << pageBits) - 1) >> pageBits;
+    out.resize(pages);
+    in.resize(pages);
+    for (uint32_t i = 0; i < pages; i++) {
+        uint32_t first = i << pageBits, last = min(numNodes, first + (1u << pageBits));
+        out.set(i, rowsOf(g, first, last, true));
+        in.set(i, rowsOf(g, first, last, false));
+    }
+}
+
+// Walk the edits page by page; each touched page is copied once, merging every row with its sorted adds and drops
+void pagedCsr::editPages(pageTable<csrPage>& table, const vector<uint64_t>& adds, const vector<uint64_t>& drops) const {
+    size_t a = 0, d = 0;
+    while (a < adds.size() || d < drops.size()) {
+        uint32_t row = (uint32_t)(min(a < adds.size() ? adds[a] : UINT64_MAX, d < drops.size() ? drops[d] : UINT64_MAX) >> 32);
+        uint32_t pg = row >> pageBits, first = pg << pageBits, last = min(numNodes, first + (1u << pageBits));
+        const csrPage& old = table.page(pg);
+        size_t pageAdds = lower_bound(adds.begin() + a, adds.end(), (uint64_t)last << 32) - adds.begin() - a;
+        size_t pageDrops = lower_bound(drops.begin() + d, drops.end(), (uint64_t)last << 32) - drops.begin() - d;
+        shared_ptr<csrPage> p = make_shared<csrPage>();  // Sized exactly, since a page can outlive many versions
+        p->adj.reserve(old.adj.size() + pageAdds - pageDrops);
+        p->off.reserve(last - first + 1);
+        p->off.push_back(0);
+        for (uint32_t u = first; u < last; u++) {
+            const uint32_t* v = old.adj.data() + old.off[u - first];
+            const uint32_t* end = old.adj.data() + old.off[u - first + 1];
+            bool added = a < adds.size() && (uint32_t)(adds[a] >> 32) == u;
+            bool dropped = d < drops.size() && (uint32_t)(drops[d] >> 32) == u;
+            if (!added && !dropped) {  // Rows without edits are copied as they are
+                p->adj.insert(p->adj.end(), v, end);
+                p->off.push_back((uint32_t)p->adj.size());
+                continue;
+            }
+            while (v != end || added) {
+                if (added && (v == end || (uint32_t)adds[a] < *v)) {
+                    p->adj.push_back((uint32_t)adds[a++]);
+                    added = a < adds.size() && (uint32_t)(adds[a] >> 32) == u;
+                } else if (d < drops.size() && drops[d] == ((uint64_t)u << 32 | *v)) {
+                    d++;
+                    v++;
+                } else {
+                    p->adj.push_back(*v++);
+                }
+            }
+            p->off.push_back((uint32_t)p->adj.size());
+        }
+        table.set(pg, move(p));
+    }
+}
+
+pagedCsr* pagedCsr::withEdits(const vector<uint64_t>& adds, const vector<uint64_t>& drops) const {
+    pagedCsr* h = new pagedCsr(*this);  // Shares every page; only the directory lists are copied
+    h->numEdges = numEdges + adds.size() - drops.size();
+    editPages(h->out, adds, drops);
+
+    // The same edits by followed user, for the follower rows
+    vector<uint64_t> inAdds(adds.size()), inDrops(drops.size());
+    for (size_t i = 0; i < adds.size(); i++) inAdds[i] = adds[i] << 32 | adds[i] >> 32;
+    for (size_t i = 0; i < drops.size(); i++) inDrops[i] = drops[i] << 32 | drops[i] >> 32;
+    sort(inAdds.begin(), inAdds.end());
+    sort(inDrops.begin(), inDrops.end());
+    editPages(h->in, inAdds, inDrops);
+    return h;
+}
+
+#endif
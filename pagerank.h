@@ -0,0 +1,132 @@
+#ifndef _PAGERANK_H_
+#define _PAGERANK_H_
+
+/*
+PageRank:
+-Centrality over a CSR snapshot (see csr.h): following someone passes a share of your rank to them
+-Power iteration with a configurable damping factor, stopping once the L1 change of an iteration drops below a tolerance
+-Users who follow nobody spread their rank evenly over everyone
+-Pull-based: each user sums the contributions of its followers straight out of the contiguous inAdj rows,
+    so every rank is written by exactly one thread and no atomics or locks are needed
+-Vertices are split into contiguous ranges with roughly equal edge counts, one per worker thread;
+    the workers live for the whole run and meet at a barrier between phases
+*/
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include "csr.h"
+using namespace std;
+
+// Reusable barrier for a fixed number of threads
+class prBarrier {
+private:
+    mutex lock;
+    condition_variable cv;
+    unsigned count;                // Threads that must arrive
+    unsigned waiting;              // Threads that have arrived in this round
+    unsigned round;                // Bumped each time the barrier opens
+
+public:
+    prBarrier(unsigned n) : count(n), waiting(0), round(0) {}
+
+    void wait() {
+        unique_lock<mutex> guard(lock);
+        unsigned r = round;
+        if (++waiting == count) {  // Last one in opens the barrier
+            waiting = 0;
+            round++;
+            cv.notify_all();
+        }
+        else cv.wait(guard, [&] { return round != r; });
+    }
+};
+
+// Fill rank with each vertex's PageRank (summing to 1) and return the number of iterations run
+// threads = 0 picks one thread per core, scaled down for small graphs
+int pageRank(const csrGraph& g, vector<double>& rank, double damping, double tolerance, int maxIter, unsigned threads) {
+    uint32_t n = g.numNodes;
+    rank.assign(n, n ? 1.0 / n : 0.0);
+    if (!n) return 0;
+
+    const uint64_t edgesPerThread = 1 << 16;  // Below this much work per thread, extra threads cost more than they save
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<uint64_t>(1, min<uint64_t>(threads, (g.numEdges + n) / edgesPerThread));
+
+    // Split the vertices into ranges of roughly equal (edges + vertices)
+    vector<uint32_t> bound(threads + 1, n);
+    bound[0] = 0;
+    for (unsigned t = 1; t < threads; t++) {
+        uint64_t target = (g.numEdges + n) * t / threads;
+        uint32_t lo = bound[t - 1], hi = n;
+        while (lo < hi) {  // First vertex whose prefix (edges + vertices) reaches the target
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (g.inOff[mid] + mid < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bound[t] = lo;
+    }
+
+    vector<double> contrib(n);               // rank / outDeg of each vertex for the current iteration
+    vector<double> next(n);
+    vector<double> dangling(threads), delta(threads);  // Per-thread partial sums
+    prBarrier barrier(threads);
+    int iterations = 0;
+    bool done = false;
+
+    auto worker = [&](unsigned t) {
+        uint32_t lo = bound[t], hi = bound[t + 1];
+        for (int it = 0; it < maxIter; it++) {
+            // Phase 1: work out what each vertex hands to each user it follows
+            double lost = 0;
+            for (uint32_t v = lo; v < hi; v++) {
+                uint32_t deg = g.outDeg(v);
+                if (deg) contrib[v] = rank[v] / deg;
+                else {
+                    contrib[v] = 0;
+                    lost += rank[v];  // Follows nobody: spread evenly instead
+                }
+            }
+            dangling[t] = lost;
+            barrier.wait();
+
+            // Phase 2: pull from followers
+            double spread = 0;
+            for (unsigned i = 0; i < threads; i++) spread += dangling[i];
+            double base = (1.0 - damping) / n + damping * spread / n;
+            double change = 0;
+            for (uint32_t v = lo; v < hi; v++) {
+                double sum = 0;
+                for (const uint32_t* f = g.inBegin(v); f != g.inEnd(v); f++) sum += contrib[*f];
+                next[v] = base + damping * sum;
+                change += fabs(next[v] - rank[v]);
+            }
+            delta[t] = change;
+            barrier.wait();
+
+            // Phase 3: thread 0 publishes the new ranks and decides whether to stop
+            if (t == 0) {
+                rank.swap(next);
+                double total = 0;
+                for (unsigned i = 0; i < threads; i++) total += delta[i];
+                iterations = it + 1;
+                done = total < tolerance;
+            }
+            barrier.wait();
+            if (done) break;
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.push_back(thread(worker, t));
+    worker(0);
+    for (thread& th : pool) th.join();
+
+    return iterations;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+/*
+Pool:
+-Slab allocator for one type of fixed-size object (aNode, tNode, adjList, user)
+-Objects are carved out of large slabs instead of one heap allocation each:
+    -slabs start small and double in size up to maxSlab objects, so tiny networks stay tiny
+    -freed objects go on an intrusive free list and are handed out again before the slab grows
+-make() constructs an object in the pool and destroy() runs its destructor and gives the slot back
+-absorb() takes over another pool's slabs, so worker threads can fill pools of their own and hand the objects
+    to the owner afterwards (see graph::addEdges); its unused slots join this pool's free list
+-release() (and the destructor) drops every slab at once WITHOUT running any destructors:
+    the owner destroys whatever still needs it (e.g. strings) first, then lets the memory go in a few frees
+-Counters report how many objects were made and how much memory the slabs hold
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+using namespace std;
+
+template <typename T>
+class memPool {
+private:
+    union slot {  // One object's worth of memory, or a link in the free list while it is unused
+        slot* next;
+        typename aligned_storage<sizeof(T), alignof(T)>::type obj;
+    };
+
+    static const size_t firstSlab = 64;  // Objects in the first slab
+    static const size_t maxSlab = 65536;  // Objects in the largest slab
+
+    vector<slot*> slabs;  // Every slab (so they can be released)
+    slot* freeList;  // Slots given back by destroy()
+    slot* cur;  // Next unused slot in the newest slab
+    slot* end;  // One past the last slot in the newest slab
+    size_t nextSlab;  // Size of the next slab to allocate
+
+    size_t liveCt;  // Objects currently constructed
+    size_t madeCt;  // Objects ever constructed
+    size_t bytesCt;  // Bytes held by the slabs
+
+    memPool(const memPool&);  // Pools own their slabs, so they cannot be copied
+    memPool& operator=(const memPool&);
+
+public:
+    memPool() : freeList(nullptr), cur(nullptr), end(nullptr), nextSlab(firstSlab), liveCt(0), madeCt(0), bytesCt(0) {}
+    ~memPool() { release(); }
+
+    template <typename... Args>
+    T* make(Args&&... args) {  // Construct a new object in the pool
+        slot* s;
+        if (freeList) {  // Reuse a freed slot first
+            s = freeList;
+            freeList = freeList->next;
+        } else {
+            if (cur == end) {  // Newest slab is full: start a bigger one
+                cur = static_cast<slot*>(::operator new(nextSlab * sizeof(slot)));
+                end = cur + nextSlab;
+                slabs.push_back(cur);
+                bytesCt += nextSlab * sizeof(slot);
+                if (nextSlab < maxSlab) nextSlab *= 2;
+            }
+            s = cur++;
+        }
+        T* obj = new (&s->obj) T(std::forward<Args>(args)...);
+        liveCt++;
+        madeCt++;
+        return obj;
+    }
+
+    void destroy(T* obj) {  // Destroy an object and give its slot back
+        if (!obj) return;
+        obj->~T();
+        slot* s = reinterpret_cast<slot*>(obj);
+        s->next = freeList;
+        freeList = s;
+        liveCt--;
+    }
+
+    void absorb(memPool& other) {  // Take over other's slabs and the objects in them, leaving other empty
+        slabs.insert(slabs.end(), other.slabs.begin(), other.slabs.end());
+        for (slot* s = other.cur; s != other.end; s++) {  // The rest of other's newest slab is free for reuse
+            s->next = freeList;
+            freeList = s;
+        }
+        while (other.freeList) {
+            slot* s = other.freeList;
+            other.freeList = s->next;
+            s->next = freeList;
+            freeList = s;
+        }
+        liveCt += other.liveCt;
+        madeCt += other.madeCt;
+        bytesCt += other.bytesCt;
+        other.slabs.clear();
+        other.cur = other.end = nullptr;
+        other.nextSlab = firstSlab;
+        other.liveCt = other.madeCt = other.bytesCt = 0;
+    }
+
+    void release() {  // Drop every slab at once (no destructors run)
+        for (slot* slab : slabs) ::operator delete(slab);
+        slabs.clear();
+        freeList = cur = end = nullptr;
+        nextSlab = firstSlab;
+        liveCt = 0;
+        bytesCt = 0;
+    }
+
+    size_t live() const { return liveCt; }  // Objects currently constructed
+    size_t made() const { return madeCt; }  // Objects ever constructed (each one would have been a separate new)
+    size_t slabCt() const { return slabs.size(); }  // Heap allocations actually made
+    size_t bytes() const { return bytesCt; }  // Bytes held by the slabs
+    static size_t objectBytes() { return sizeof(slot); }  // Bytes per object
+};
+
+template <typename T> const size_t memPool<T>::firstSlab;
+template <typename T> const size_t memPool<T>::maxSlab;
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef _RADIXSORT_H_
+#define _RADIXSORT_H_
+
+/*
+Radix sort:
+-Parallel LSD radix sort of 64-bit keys, one byte per pass
+-Used to group and dedupe follow edges packed as (follower << 32) | followed (see graph::bulkFollow)
+-Each pass: every thread counts the digits in its slice, the counts are turned into one write position per
+    (digit, thread), and every thread scatters its slice into the other buffer; the result is stable
+-Passes where every key has the same digit are skipped, so small IDs (with zero high bytes) cost fewer passes
+*/
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <algorithm>
+using namespace std;
+
+// Sort keys in place using `threads` threads (0 = one per core)
+void radixSort(vector<uint64_t>& keys, unsigned threads = 0) {
+    const size_t minSlice = 1 << 16;  // Don't start a thread for fewer keys than this
+    const int radix = 256;
+    size_t n = keys.size();
+    if (n < 2) return;
+
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<size_t>(1, min<size_t>(threads, n / minSlice));
+
+    // Bits that differ somewhere tell which bytes need a pass
+    uint64_t all = keys[0], any = 0;
+    for (uint64_t k : keys) any |= k ^ all;
+
+    vector<uint64_t> buf(n);
+    vector<size_t> count((size_t)threads * radix);
+    uint64_t* src = keys.data();
+    uint64_t* dst = buf.data();
+    auto begin = [&](unsigned t) { return n / threads * t; };
+    auto end = [&](unsigned t) { return t + 1 == threads ? n : n / threads * (t + 1); };
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (!((any >> shift) & 0xFF)) continue;  // Every key has the same byte here
+
+        // Count each thread's digits
+        auto countSlice = [&](unsigned t) {
+            size_t* c = &count[(size_t)t * radix];
+            fill(c, c + radix, 0);
+            for (size_t i = begin(t); i < end(t); i++) c[(src[i] >> shift) & 0xFF]++;
+        };
+        // Scatter each thread's slice; its first write for a digit follows every earlier digit and every earlier thread's copies of this one
+        auto scatterSlice = [&](unsigned t) {
+            size_t* c = &count[(size_t)t * radix];
+            for (size_t i = begin(t); i < end(t); i++) dst[c[(src[i] >> shift) & 0xFF]++] = src[i];
+        };
+
+        vector<thread> pool;
+        for (unsigned t = 1; t < threads; t++) pool.push_back(thread(countSlice, t));
+        countSlice(0);
+        for (thread& th : pool) th.join();
+
+        size_t pos = 0;  // Exclusive prefix sum, digit-major then thread
+        for (int d = 0; d < radix; d++) {
+            for (unsigned t = 0; t < threads; t++) {
+                size_t c = count[(size_t)t * radix + d];
+                count[(size_t)t * radix + d] = pos;
+                pos += c;
+            }
+        }
+
+        pool.clear();
+        for (unsigned t = 1; t < threads; t++) pool.push_back(thread(scatterSlice, t));
+        scatterSlice(0);
+        for (thread& th : pool) th.join();
+
+        swap(src, dst);
+    }
+
+    if (src != keys.data()) keys.swap(buf);  // An odd number of passes left the result in buf
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _SCC_H_
+#define _SCC_H_
+
+/*
+SCC:
+-Strongly connected components of a CSR snapshot (see csr.h), using Tarjan's algorithm
+-Iterative: the DFS keeps an explicit stack of (vertex, next edge) frames instead of recursing,
+    so huge components cannot overflow the call stack
+-Linear time: every vertex is pushed once and every edge is looked at once
+-Components come out in reverse topological order (a component only follows earlier components)
+*/
+
+#include <cstdint>
+#include <vector>
+#include "csr.h"
+using namespace std;
+
+// Fill comp[v] with the component ID of each vertex and sizes[c] with the size of component c
+// Returns the number of components
+uint32_t findScc(const csrGraph& g, vector<uint32_t>& comp, vector<uint32_t>& sizes) {
+    const uint32_t NONE = UINT32_MAX;
+    uint32_t n = g.numNodes;
+
+    vector<uint32_t> index(n, NONE);  // DFS discovery order of each vertex
+    vector<uint32_t> low(n);          // Lowest discovery index reachable from the vertex's subtree
+    vector<uint32_t> stack;           // Vertices whose component is not known yet
+    vector<pair<uint32_t, uint64_t>> frames;  // DFS call stack: (vertex, offset of the next edge to try)
+    comp.assign(n, NONE);             // Doubles as the on-stack test: visited but no component yet
+    sizes.clear();
+
+    uint32_t counter = 0;
+    for (uint32_t root = 0; root < n; root++) {
+        if (index[root] != NONE) continue;
+
+        index[root] = low[root] = counter++;
+        stack.push_back(root);
+        frames.push_back(make_pair(root, g.outOff[root]));
+
+        while (!frames.empty()) {
+            uint32_t v = frames.back().first;
+
+            if (frames.back().second < g.outOff[v + 1]) {  // Try v's next edge
+                uint32_t w = g.outAdj[frames.back().second++];
+                if (index[w] == NONE) {  // Tree edge: "recurse" into w
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w);
+                    frames.push_back(make_pair(w, g.outOff[w]));
+                }
+                else if (comp[w] == NONE && index[w] < low[v]) {  // Edge back into the current stack
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            // All of v's edges are done: "return" to the parent
+            frames.pop_back();
+            if (low[v] == index[v]) {  // v is the root of a component; pop it off the stack
+                uint32_t c = (uint32_t)sizes.size();
+                uint32_t size = 0;
+                uint32_t w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    comp[w] = c;
+                    size++;
+                } while (w != v);
+                sizes.push_back(size);
+            }
+            if (!frames.empty() && low[v] < low[frames.back().first]) low[frames.back().first] = low[v];
+        }
+    }
+
+    return (uint32_t)sizes.size();
+}
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+/*
+Server:
+-Answers commands against a network that is loaded once (main -serve), over stdin/stdout or a local Unix socket
+-One command per line, words separated by spaces or tabs, and one response line per command, in order:
+    suggest <user> [k]                  friend suggestions (5 by default)
+    sep <user1> <user2>                 degree of separation (-1 if there is no path)
+    top-connected [k] [total|in|out]    most connected users (10 by default) with their degree
+    top-influential [k]                 users with the highest PageRank (10 by default)
+    follow <user1> <user2>              1 if the follow is new, 0 if it already existed
+    unfollow <user1> <user2>            1 if there was such a follow, 0 if not
+    stats                               network size and suggestion cache counters (the whole stats dump in JSON)
+    format line|json                    switch the session's response format
+    quit                                end the session
+-Line responses are "ok <result>" or "err <message>"; JSON responses are {"ok": true, "result": ...}
+    or {"ok": false, "error": "..."}
+-Commands are pipelined: a client can send any number of them without waiting, and everything that arrives
+    in one read is answered as one batch, with all of its responses queued for sending together
+-Each sep goes through the graph's bidirectional BFS on its own: it touches a small part of the network, where
+    the batched multi-source BFS (see msbfs.h) sweeps all of it, so it stays cheaper even for long runs of seps
+-PageRank is kept between requests (the top users for the largest k asked) until a follow or unfollow changes an edge
+-The socket server polls the listening socket and every client, so several clients can stay connected;
+    batches are answered one at a time, so nothing races on the graph
+-Client sockets are non-blocking: each session queues its responses and sends what the client will take whenever
+    poll says it can, so a client that sends commands without reading its answers only ever stalls itself
+    (the server stops reading from it once outCap bytes of answers are waiting)
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "graph.h"
+#include "stats.h"
+using namespace std;
+
+struct serverSession {
+    string pending;                // Bytes received after the last complete line
+    string unsent;                 // Responses the client hasn't taken yet (socket sessions only)
+    bool json;                     // Answer in JSON rather than in lines
+    bool open;                     // False once the client has sent quit
+    bool hungUp;                   // The client has closed its end (the last answers may still be waiting in unsent)
+
+    serverSession() : json(false), open(true), hungUp(false) {}
+};
+
+class graphServer {
+private:
+    graph& g;
+    vector<uint32_t> influential;  // Cached PageRank leaders, best first
+    int influentialAsked;          // The k they were found for (-1 = nothing cached)
+
+    static const size_t readSize = 1 << 16;  // Bytes read at a time
+    static const size_t outCap = 1 << 20;    // Answers a socket session may have waiting before its commands stop being read
+
+    void answer(const vector<string>& words, serverSession& s, string& out);  // Answer one command
+    const vector<uint32_t>& topInfluential(int k);  // The k highest PageRank users (or all of them, if fewer)
+
+public:
+    explicit graphServer(graph& network);
+
+    void batch(const char* data, size_t len, bool eof, serverSession& s, string& out);  // Answer every complete line in data (and the rest, at eof)
+    int serveStream(int inFd, int outFd);    // Serve one session until end of input; returns 0, or 1 on an I/O error
+    int serveSocket(const string& path);     // Serve clients on a Unix socket until the process is stopped; returns 1 if it can't listen
+};
+
+const size_t graphServer::readSize;
+const size_t graphServer::outCap;
+
+// Quote a string for JSON
+string jsonString(const string& str) {
+    string quoted = "\"";
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        if (c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            quoted += code;
+        } else {
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// Append one response: line is the line format's result, json the JSON value
+void serverReply(const serverSession& s, string& out, const string& line, const string& json) {
+    if (s.json) out += "{\"ok\": true, \"result\": " + json + "}\n";
+    else out += line.empty() ? "ok\n" : "ok " + line + "\n";
+}
+
+void serverError(const serverSession& s, string& out, const string& message) {
+    if (s.json) out += "{\"ok\": false, \"error\": " + jsonString(message) + "}\n";
+    else out += "err " + message + "\n";
+}
+
+// Read a count argument: def if it is missing, -1 if it isn't a positive number
+int serverCount(const vector<string>& words, size_t at, int def) {
+    if (words.size() <= at) return def;
+    char* end;
+    long k = strtol(words[at].c_str(), &end, 10);
+    return *end || k <= 0 ? -1 : (int)min<long>(k, 1 << 30);
+}
+
+// Write all of data, retrying short writes (the stdin/stdout session, which has no one else to wait for it)
+bool writeAll(int fd, const string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Send as much of data as a non-blocking socket takes right now, and drop that part from data; false if the client is gone
+// (send rather than write, so a closed client doesn't raise SIGPIPE)
+bool sendSome(int fd, string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;  // The client's buffer is full; poll says when to go on
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    data.erase(0, done);
+    return true;
+}
+
+graphServer::graphServer(graph& network) : g(network), influentialAsked(-1) {}
+
+const vector<uint32_t>& graphServer::topInfluential(int k) {
+    if (influentialAsked < 0 || (k > influentialAsked && (int)influential.size() == influentialAsked)) {
+        vector<double> rank;
+        g.pageRank(rank);
+        influential = topIds(rank.data(), (uint32_t)rank.size(), k);
+        influentialAsked = k;
+    }
+    return influential;
+}
+
+void graphServer::batch(const char* data, size_t len, bool eof, serverSession& s, string& out) {
+    STAT_TIME(statServeBatch);
+    s.pending.append(data, len);
+
+    // Split off every complete line (and, at the end of input, whatever is left)
+    vector<vector<string>> cmds;
+    size_t start = 0;
+    while (start < s.pending.size()) {
+        size_t nl = s.pending.find('\n', start);
+        if (nl == string::npos && !eof) break;
+        if (nl == string::npos) nl = s.pending.size();
+        vector<string> words;
+        for (size_t i = start; i < nl; ) {
+            while (i < nl && (s.pending[i] == ' ' || s.pending[i] == '\t' || s.pending[i] == '\r')) i++;
+            size_t w = i;
+            while (i < nl && s.pending[i] != ' ' && s.pending[i] != '\t' && s.pending[i] != '\r') i++;
+            if (i > w) words.push_back(s.pending.substr(w, i - w));
+        }
+        if (!words.empty()) cmds.push_back(words);
+        start = nl + 1;
+    }
+    s.pending.erase(0, min(start, s.pending.size()));
+
+    for (size_t i = 0; i < cmds.size() && s.open; i++) answer(cmds[i], s, out);
+}
+
+void graphServer::answer(const vector<string>& words, serverSession& s, string& out) {
+    STAT_TIME(statServeCommand);
+    const string& cmd = words[0];
+
+    if (cmd == "suggest") {
+        int k = serverCount(words, 2, 5);
+        if (words.size() < 2 || words.size() > 3 || k < 0) return serverError(s, out, "usage: suggest <user> [k]");
+        k = min(k, g.usrCt());
+        int found = 0;
+        user** suggestions = g.suggestFriends(words[1], k, &found);
+        if (!suggestions) return serverError(s, out, "unknown user " + words[1]);
+        string line, json = "[";
+        for (int i = 0; i < found; i++) {
+            line += (i ? " " : "") + suggestions[i]->username;
+            json += (i ? ", " : "") + jsonString(suggestions[i]->username);
+        }
+        delete[] suggestions;
+        return serverReply(s, out, line, json + "]");
+    }
+
+    if (cmd == "sep") {
+        if (words.size() != 3) return serverError(s, out, "usage: sep <user1> <user2>");
+        int from = g.userIndex(words[1]), to = g.userIndex(words[2]);
+        if (from < 0 || to < 0) return serverError(s, out, "unknown user " + words[from < 0 ? 1 : 2]);
+        string d = to_string(g.sepDegree(from, to));
+        return serverReply(s, out, d, d);
+    }
+
+    if (cmd == "top-connected") {
+        int k = serverCount(words, 1, 10);
+        degreeKind by = degreeTotal;
+        if (words.size() > 2 && words[2] == "in") by = degreeIn;
+        else if (words.size() > 2 && words[2] == "out") by = degreeOut;
+        else if (words.size() > 2 && words[2] != "total") k = -1;
+        if (words.size() > 3 || k < 0) return serverError(s, out, "usage: top-connected [k] [total|in|out]");
+        k = min(k, g.usrCt());
+        user** top = g.mostConnected(k, by);
+        string line, json = "[";
+        for (int i = 0; i < k; i++) {
+            int d = by == degreeIn ? top[i]->numFollowers : by == degreeOut ? top[i]->numFollowing : top[i]->numFollowers + top[i]->numFollowing;
+            line += (i ? " " : "") + top[i]->username + ":" + to_string(d);
+            json += string(i ? ", " : "") + "{\"user\": " + jsonString(top[i]->username) + ", \"degree\": " + to_string(d) + "}";
+        }
+        delete[] top;
+        return serverReply(s, out, line, json + "]");
+    }
+
+    if (cmd == "top-influential") {
+        int k = serverCount(words, 1, 10);
+        if (words.size() > 2 || k < 0) return serverError(s, out, "usage: top-influential [k]");
+        const vector<uint32_t>& top = topInfluential(k);
+        string line, json = "[";
+        for (size_t i = 0; i < top.size() && (int)i < k; i++) {
+            string name = g.username(top[i]);
+            line += (i ? " " : "") + name;
+            json += (i ? ", " : "") + jsonString(name);
+        }
+        return serverReply(s, out, line, json + "]");
+    }
+
+    if (cmd == "follow" || cmd == "unfollow") {
+        if (words.size() != 3) return serverError(s, out, "usage: " + cmd + " <user1> <user2>");
+        if (g.userIndex(words[1]) < 0 || g.userIndex(words[2]) < 0) {
+            return serverError(s, out, "unknown user " + words[g.userIndex(words[1]) < 0 ? 1 : 2]);
+        }
+        bool changed = cmd == "follow" ? g.follow(words[1], words[2]) : g.unfollow(words[1], words[2]);
+        if (changed) influentialAsked = -1;  // PageRank has to be run again
+        return serverReply(s, out, changed ? "1" : "0", changed ? "true" : "false");
+    }
+
+    if (cmd == "stats") {
+        if (s.json) {
+            ostringstream dump;
+            g.dumpStats(true, dump);
+            string json = dump.str();
+            json.erase(json.find_last_not_of('\n') + 1);
+            return serverReply(s, out, "", json);
+        }
+        return serverReply(s, out, "users=" + to_string(g.usrCt()) + " follows=" + to_string(g.followCt())
+                           + " suggestCacheHits=" + to_string(g.suggestCacheHits()) + " suggestCacheMisses=" + to_string(g.suggestCacheMisses()), "");
+    }
+
+    if (cmd == "format") {
+        if (words.size() != 2 || (words[1] != "line" && words[1] != "json")) return serverError(s, out, "usage: format line|json");
+        s.json = words[1] == "json";
+        return serverReply(s, out, words[1], jsonString(words[1]));
+    }
+
+    if (cmd == "quit") {
+        serverReply(s, out, "bye", "\"bye\"");
+        s.open = false;
+        return;
+    }
+
+    serverError(s, out, "unknown command " + cmd);
+}
+
+int graphServer::serveStream(int inFd, int outFd) {
+    serverSession s;
+    vector<char> buf(readSize);
+    string out;
+    while (s.open) {
+        ssize_t n = read(inFd, buf.data(), buf.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return 1;
+        out.clear();
+        batch(buf.data(), (size_t)n, n == 0, s, out);
+        if (!writeAll(outFd, out)) return 1;
+        if (n == 0) break;
+    }
+    return 0;
+}
+
+int graphServer::serveSocket(const string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Socket path " << path << " is too long!" << endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());  // A socket file left behind by an earlier run
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0) {
+        cerr << "Error listening on " << path << "!" << endl;
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+
+    vector<pollfd> fds(1);         // The listener, then one entry per client
+    vector<serverSession> sessions(1);  // Parallel to fds (the listener's entry is unused)
+    fds[0].fd = listener;
+    fds[0].events = POLLIN;
+    vector<char> buf(readSize);
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (size_t i = fds.size(); i-- > 1; ) {
+            if (!fds[i].revents) continue;
+            serverSession& s = sessions[i];
+            bool alive = true;
+            if ((fds[i].events & POLLIN) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                ssize_t n = read(fds[i].fd, buf.data(), buf.size());
+                if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) alive = false;
+                if (n >= 0) batch(buf.data(), (size_t)n, n == 0, s, s.unsent);  // On hang-up this answers a last unterminated line
+                if (n == 0) s.hungUp = true;
+            }
+            alive = alive && sendSome(fds[i].fd, s.unsent);
+            if (!alive || ((s.hungUp || !s.open) && s.unsent.empty())) {  // Failed, or hung up or quit with everything sent
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+                sessions.erase(sessions.begin() + i);
+                continue;
+            }
+            // Read more only while the session is still going and its answers are being taken; wait to send while any are queued
+            fds[i].events = (short)((s.open && !s.hungUp && s.unsent.size() < outCap ? POLLIN : 0) | (s.unsent.empty() ? 0 : POLLOUT));
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0 && fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK) < 0) {
+                close(client);
+                client = -1;
+            }
+            if (client >= 0) {
+                pollfd p;
+                p.fd = client;
+                p.events = POLLIN;
+                p.revents = 0;
+                fds.push_back(p);
+                sessions.push_back(serverSession());
+            }
+        }
+    }
+    close(listener);
+    unlink(path.c_str());
+    return 1;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+/*
+Snapshot file:
+-Binary image of a whole network, written by graph::saveSnapshot and opened by graph::loadSnapshot
+-Laid out so it can be memory-mapped and used in place: the CSR arrays (see csr.h) are read straight out of the
+    mapping, so opening a snapshot costs about one pass over the users rather than a rebuild of every edge,
+    and several processes mapping the same file share one copy of it in the page cache
+-Layout (every section starts on a 64-byte boundary, all integers in the writer's byte order):
+    -header (snapHeader): magic, format version, byte-order mark, sizes, and the offset of every section
+    -strOff: uint64[3 * numNodes + 1], where user i's username, firstname and lastname are strings 3i, 3i + 1, 3i + 2
+    -strData: the characters of every string, back to back (string j is strData[strOff[j], strOff[j + 1]))
+    -order: uint32[numNodes], the user IDs in username order (so the vertex index bulk-loads with no sort)
+    -outOff, outAdj, inOff, inAdj: the CSR arrays for both directions
+-The section offsets follow from the sizes alone, so a reader recomputes them and rejects any header that disagrees
+-Bump snapVersion whenever the layout changes
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include "csr.h"
+using namespace std;
+
+const char snapMagic[8] = {'S', 'O', 'C', 'G', 'R', 'A', 'P', 'H'};  // First 8 bytes of every snapshot
+const uint32_t snapVersion = 1;  // Current layout version
+const uint32_t snapEndian = 0x01020304;  // Reads back differently on a machine with the other byte order
+const uint64_t snapAlign = 64;  // Section alignment
+
+enum snapSection { secStrOff, secStrData, secOrder, secOutOff, secOutAdj, secInOff, secInAdj, snapSections };
+
+struct snapHeader {
+    char magic[8];                 // snapMagic
+    uint32_t version;              // snapVersion
+    uint32_t endian;               // snapEndian, as written
+    uint32_t numNodes;             // Number of users
+    uint32_t reserved;             // Zero
+    uint64_t numEdges;             // Number of follow edges
+    uint64_t strBytes;             // Size of the strData section
+    uint64_t fileSize;             // Size of the whole file
+    uint64_t sections[snapSections];  // Byte offset of each section from the start of the file
+};
+
+// Fill in the section offsets and file size from numNodes, numEdges and strBytes
+void snapLayout(snapHeader& h) {
+    uint64_t bytes[snapSections] = {
+        (3ull * h.numNodes + 1) * sizeof(uint64_t),  // strOff
+        h.strBytes,                                  // strData
+        (uint64_t)h.numNodes * sizeof(uint32_t),     // order
+        (h.numNodes + 1ull) * sizeof(uint64_t),      // outOff
+        h.numEdges * sizeof(uint32_t),               // outAdj
+        (h.numNodes + 1ull) * sizeof(uint64_t),      // inOff
+        h.numEdges * sizeof(uint32_t)                // inAdj
+    };
+    uint64_t at = sizeof(snapHeader);
+    for (int s = 0; s < snapSections; s++) {
+        at = (at + snapAlign - 1) / snapAlign * snapAlign;
+        h.sections[s] = at;
+        at += bytes[s];
+    }
+    h.fileSize = at;
+}
+
+// Whether a header read from a file of `size` bytes describes a snapshot this build can use
+bool snapCheck(const snapHeader& h, uint64_t size) {
+    if (memcmp(h.magic, snapMagic, sizeof(snapMagic)) || h.version != snapVersion || h.endian != snapEndian) return false;
+    if (h.numEdges > size || h.strBytes > size) return false;  // Keeps the layout arithmetic from overflowing
+
+    snapHeader expect = h;
+    snapLayout(expect);
+    return expect.fileSize == h.fileSize && h.fileSize == size && !memcmp(expect.sections, h.sections, sizeof(h.sections));
+}
+
+// Write `bytes` bytes at offset `at`, zero-padding from the current position
+bool snapWrite(ofstream& out, uint64_t at, const void* data, uint64_t bytes) {
+    static const char zeros[snapAlign] = {};
+    uint64_t pos = (uint64_t)out.tellp();
+    if (pos > at) return false;  // Sections must be written in order
+    out.write(zeros, at - pos);
+    out.write(static_cast<const char*>(data), bytes);
+    return (bool)out;
+}
+
+// Write a snapshot of g to `path`; order lists the IDs in username order, and field(id, f) returns user id's
+// username (f = 0), firstname (1) or lastname (2)
+// The file is written under a temporary name and renamed into place, so a process that has the old snapshot
+// mapped keeps a consistent copy
+template <typename F>
+bool writeSnapshot(const string& path, const csrGraph& g, const uint32_t* order, F field) {
+    uint32_t n = g.numNodes;
+
+    snapHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, snapMagic, sizeof(snapMagic));
+    h.version = snapVersion;
+    h.endian = snapEndian;
+    h.numNodes = n;
+    h.numEdges = g.numEdges;
+
+    // String offsets: username, firstname, lastname of each user in ID order
+    vector<uint64_t> strOff(3 * (size_t)n + 1, 0);
+    for (size_t j = 0; j < 3 * (size_t)n; j++) strOff[j + 1] = strOff[j] + field((uint32_t)(j / 3), (int)(j % 3)).size();
+    h.strBytes = strOff.back();
+    snapLayout(h);
+
+    string tmp = path + ".tmp";
+    ofstream out(tmp.c_str(), ios::binary | ios::trunc);
+    bool ok = (bool)out && snapWrite(out, 0, &h, sizeof(h));
+    ok = ok && snapWrite(out, h.sections[secStrOff], strOff.data(), strOff.size() * sizeof(uint64_t));
+    for (size_t j = 0; ok && j < 3 * (size_t)n; j++) {
+        const string& s = field((uint32_t)(j / 3), (int)(j % 3));
+        ok = snapWrite(out, h.sections[secStrData] + strOff[j], s.data(), s.size());
+    }
+    ok = ok && snapWrite(out, h.sections[secOrder], order, (uint64_t)n * sizeof(uint32_t));
+    ok = ok && snapWrite(out, h.sections[secOutOff], g.outOff, (n + 1ull) * sizeof(uint64_t));
+    ok = ok && snapWrite(out, h.sections[secOutAdj], g.outAdj, g.numEdges * sizeof(uint32_t));
+    ok = ok && snapWrite(out, h.sections[secInOff], g.inOff, (n + 1ull) * sizeof(uint64_t));
+    ok = ok && snapWrite(out, h.sections[secInAdj], g.inAdj, g.numEdges * sizeof(uint32_t));
+    out.close();
+
+    if (!ok || !out || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+/*
+Stats:
+-Counters, nanosecond timers and latency histograms for the hot paths in graph, AVL and adjList
+-Compiled out unless GRAPH_STATS is defined (make STATS=1): the STAT_ macros then expand to nothing,
+    so a normal build runs exactly the code it ran before
+-Every stat is one slot of a fixed, process-wide table (statId), so recording never allocates or looks anything up
+-A slot keeps a count, a sum, a max and a log2 histogram: bucket b holds the values in [2^(b - 1), 2^b),
+    and bucket 0 holds zeros; percentiles are read off the buckets (so they are within a factor of two)
+-Three kinds of stat:
+    -timers record nanoseconds per call (STAT_TIME times the rest of the enclosing scope)
+    -values record a size per call, e.g. the depth an AVL lookup reached or the nodes an adjList view scanned
+    -counters just count events
+-Updates are relaxed atomics, because the parallel loaders look users up from several threads at once
+-statDump prints the table as text or JSON; graph::dumpStats adds the network's own sizes
+*/
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+enum statKind { statTimer, statValue, statCounter };
+
+enum statId {
+    // Loading and saving
+    statLoadCsv, statLoadEdges, statLoadSnapshot, statSaveSnapshot, statGenerate, statAddEdges, statBuildLists, statFreeze,
+    // Edge changes
+    statFollow, statUnfollow, statRemoveUser, statLiveApply, statIngestCompact,
+    // Server
+    statServeBatch, statServeCommand,
+    // Queries
+    statSuggest, statSuggestBatch, statConnected, statInfluential, statReaching, statBridges, statSep, statSepBatch, statDistancesFrom, statDistances,
+    statPageRank, statBetweenness, statScc,
+    // AVL and adjacency lists
+    statAvlRetrieve, statAvlMiss, statViewId,
+    statCount
+};
+
+struct statInfo {
+    const char* name;              // Name in the dump
+    statKind kind;                 // What the recorded values are
+};
+
+// Names and kinds, in statId order
+const statInfo statInfos[statCount] = {
+    {"graph.loadCsv", statTimer}, {"graph.loadEdges", statTimer}, {"graph.loadSnapshot", statTimer},
+    {"graph.saveSnapshot", statTimer}, {"graph.generate", statTimer}, {"graph.addEdges", statTimer},
+    {"graph.buildLists", statTimer}, {"graph.freeze", statTimer},
+    {"graph.follow", statTimer}, {"graph.unfollow", statTimer}, {"graph.removeUser", statTimer}, {"live.apply", statTimer}, {"ingest.compact", statTimer},
+    {"server.batch", statTimer}, {"server.command", statTimer},
+    {"graph.suggestFriends", statTimer}, {"graph.suggestFriendsBatch", statTimer}, {"graph.mostConnected", statTimer}, {"graph.mostInfluential", statTimer},
+    {"graph.mostReaching", statTimer}, {"graph.mostBetween", statTimer}, {"graph.sepDegree", statTimer},
+    {"graph.sepDegreeBatch", statTimer}, {"graph.distancesFrom", statTimer}, {"graph.distanceHistogram", statTimer}, {"graph.pageRank", statTimer},
+    {"graph.betweenness", statTimer}, {"graph.stronglyConnected", statTimer},
+    {"avl.retrieve.depth", statValue}, {"avl.retrieve.miss", statCounter},
+    {"adjList.view.id.scanned", statValue}
+};
+
+const int statBuckets = 65;  // Bucket 0 for zero, then one per bit length
+
+struct statSlot {
+    atomic<uint64_t> count;        // Calls recorded
+    atomic<uint64_t> sum;          // Sum of the recorded values
+    atomic<uint64_t> max;          // Largest recorded value
+    atomic<uint64_t> buckets[statBuckets];  // Log2 histogram of the recorded values
+};
+
+// The process-wide table (static storage, so every slot starts at zero)
+statSlot* statTable() {
+    static statSlot table[statCount];
+    return table;
+}
+
+// Record one value for a stat
+void statRecord(statId id, uint64_t v) {
+    statSlot& s = statTable()[id];
+    s.count.fetch_add(1, memory_order_relaxed);
+    s.sum.fetch_add(v, memory_order_relaxed);
+    uint64_t old = s.max.load(memory_order_relaxed);
+    while (v > old && !s.max.compare_exchange_weak(old, v, memory_order_relaxed)) {}
+    s.buckets[v ? 64 - __builtin_clzll(v) : 0].fetch_add(1, memory_order_relaxed);
+}
+
+// Zero every stat
+void statReset() {
+    statSlot* table = statTable();
+    for (int i = 0; i < statCount; i++) {
+        table[i].count.store(0, memory_order_relaxed);
+        table[i].sum.store(0, memory_order_relaxed);
+        table[i].max.store(0, memory_order_relaxed);
+        for (int b = 0; b < statBuckets; b++) table[i].buckets[b].store(0, memory_order_relaxed);
+    }
+}
+
+// Value below which fraction p of a stat's values fall, to within its bucket (the bucket's top, capped at the max)
+uint64_t statPercentile(const statSlot& s, double p) {
+    uint64_t count = s.count.load(memory_order_relaxed);
+    if (!count) return 0;
+    uint64_t want = (uint64_t)(p * count) + 1, seen = 0;
+    int b = 0;
+    for (; b < statBuckets - 1; b++) {
+        seen += s.buckets[b].load(memory_order_relaxed);
+        if (seen >= want) break;
+    }
+    uint64_t top = b ? (b >= 64 ? UINT64_MAX : (1ull << b) - 1) : 0;
+    return min(top, s.max.load(memory_order_relaxed));
+}
+
+// Print every stat that has been recorded, as an aligned table or as the members of a JSON object
+// (JSON output is `"name": {...}, ...` with no braces around it, so callers can add their own members)
+void statDump(ostream& out, bool json) {
+    const char* units[] = {"ns", "", ""};
+    statSlot* table = statTable();
+    bool first = true;
+    ios::fmtflags flags = out.flags();  // Put the stream's formatting back afterwards
+    streamsize precision = out.precision();
+    if (!json) {
+        out << left << setw(28) << "stat" << right << setw(12) << "count" << setw(14) << "mean"
+            << setw(12) << "p50" << setw(12) << "p99" << setw(14) << "max" << endl;
+    }
+    for (int i = 0; i < statCount; i++) {
+        const statSlot& s = table[i];
+        const statInfo& info = statInfos[i];
+        uint64_t count = s.count.load(memory_order_relaxed);
+        if (!count) continue;
+        double mean = (double)s.sum.load(memory_order_relaxed) / count;
+
+        if (!json) {
+            out << left << setw(28) << info.name << right << setw(12) << count;
+            if (info.kind != statCounter) {
+                out << fixed << setprecision(1) << setw(14) << mean << setw(12) << statPercentile(s, 0.5)
+                    << setw(12) << statPercentile(s, 0.99) << setw(14) << s.max.load(memory_order_relaxed);
+                if (*units[info.kind]) out << " " << units[info.kind];
+            }
+            out << endl;
+            continue;
+        }
+
+        out << (first ? "" : ", ") << "\"" << info.name << "\": {\"count\": " << count;
+        if (info.kind != statCounter) {
+            out << ", \"unit\": \"" << (info.kind == statTimer ? "ns" : "count") << "\", \"sum\": " << s.sum.load(memory_order_relaxed)
+                << ", \"mean\": " << fixed << setprecision(1) << mean << ", \"p50\": " << statPercentile(s, 0.5)
+                << ", \"p99\": " << statPercentile(s, 0.99) << ", \"max\": " << s.max.load(memory_order_relaxed) << ", \"buckets\": [";
+            bool firstBucket = true;  // Nonempty buckets as [largest value, count]
+            for (int b = 0; b < statBuckets; b++) {
+                uint64_t c = s.buckets[b].load(memory_order_relaxed);
+                if (!c) continue;
+                out << (firstBucket ? "" : ", ") << "[" << (b ? (b >= 64 ? UINT64_MAX : (1ull << b) - 1) : 0) << ", " << c << "]";
+                firstBucket = false;
+            }
+            out << "]";
+        }
+        out << "}";
+        first = false;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Times the rest of the scope it is declared in
+class statScope {
+private:
+    statId id;
+    chrono::steady_clock::time_point start;
+
+public:
+    statScope(statId i) : id(i), start(chrono::steady_clock::now()) {}
+    ~statScope() { statRecord(id, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()); }
+};
+
+#ifdef GRAPH_STATS
+const bool statsEnabled = true;
+#define STAT_CONCAT2(a, b) a##b
+#define STAT_CONCAT(a, b) STAT_CONCAT2(a, b)
+#define STAT_TIME(id) statScope STAT_CONCAT(statScope_, __LINE__)(id)
+#define STAT_RECORD(id, v) statRecord(id, (uint64_t)(v))
+#define STAT_COUNT(id) statRecord(id, 1)
+#else
+const bool statsEnabled = false;
+#define STAT_TIME(id) ((void)0)
+#define STAT_RECORD(id, v) ((void)(v))  // Still "uses" v, so counting variables don't trip unused warnings
+#define STAT_COUNT(id) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef _SUGGEST_H_
+#define _SUGGEST_H_
+
+/*
+Friend suggestions:
+-Suggests the users that the most of someone's followed users follow (friends of friends), over a CSR snapshot
+    (see csr.h); the user themself and anyone they already follow are never suggested
+-Ranked by how many followed users lead to the suggestion, ties going to the lower ID
+-The engine walks edges through a forFollowing(x, visit) callable, so it runs over the CSR snapshot or,
+    right after an edge change, straight over the adjacency lists without rebuilding the snapshot
+-suggestEngine holds one thread's scratch space, sized once per snapshot and reused:
+    -count: a dense counter per user instead of a hash map, plus the list of users touched so they can be reset
+    -seen: epoch stamps marking the user and everyone they follow (see bfs.h for the epoch trick)
+    -the best k candidates are kept in a bounded heap, so picking them is O(candidates * log k)
+-suggestBatch answers many users (or everyone) on all cores:
+    -each thread has its own engine, so there is nothing shared to lock
+    -users are handed out in small chunks from an atomic counter, so a thread that draws a few hubs
+        doesn't hold up the others while they sit idle
+    -results go into a fixed-stride array (k slots per user), so threads write to disjoint slots
+-suggestCache remembers each user's last answer (the top k, best first, and the k it was made for):
+    -a later request for k' <= k reads the first k' straight back, since the top k' is a prefix of the top k
+        (as is any k' at all if fewer than k suggestions existed)
+    -a user's suggestions only depend on who they follow and who those users follow, so when u follows or
+        unfollows someone, only u and u's followers are dropped; everyone else keeps their entry
+    -hits and misses are counted
+*/
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "csr.h"
+using namespace std;
+
+class suggestEngine {
+private:
+    uint32_t epoch;                // Stamp of the current query
+    vector<uint32_t> seen;         // Epoch at which each user was marked as the asker or someone they follow
+    vector<uint32_t> count;        // Followed users leading to each candidate (zero outside a query)
+    vector<uint32_t> touched;      // Candidates with a nonzero count
+    vector<pair<uint32_t, uint32_t>> heap;  // Best candidates so far as (count, ID), weakest on top
+
+    void prepare(uint32_t n);      // Size the arrays for n users and start a new epoch
+
+public:
+    suggestEngine();
+
+    int suggest(const csrGraph& g, uint32_t u, int k, uint32_t* out);  // Fill out with up to k suggestions for u, best first; returns how many
+    template <typename F>
+    int suggest(uint32_t n, uint32_t u, int k, uint32_t* out, F forFollowing);  // Same over any edge store: forFollowing(x, visit) calls visit(y) for everyone x follows
+};
+
+suggestEngine::suggestEngine() : epoch(0) {}
+
+void suggestEngine::prepare(uint32_t n) {
+    if (seen.size() != n) {  // New snapshot size: reallocate once
+        seen.assign(n, 0);
+        count.assign(n, 0);
+        epoch = 0;
+    }
+    if (++epoch == 0) {  // The stamp wrapped around, so old stamps could look current again
+        fill(seen.begin(), seen.end(), 0);
+        epoch = 1;
+    }
+}
+
+struct csrFollowing {  // forFollowing over a CSR snapshot's out-rows
+    const csrGraph& g;
+    csrFollowing(const csrGraph& graph) : g(graph) {}
+    template <typename V>
+    void operator()(uint32_t x, V visit) const {
+        for (const uint32_t* y = g.outBegin(x); y != g.outEnd(x); y++) visit(*y);
+    }
+};
+
+int suggestEngine::suggest(const csrGraph& g, uint32_t u, int k, uint32_t* out) {
+    return suggest(g.numNodes, u, k, out, csrFollowing(g));
+}
+
+template <typename F>
+int suggestEngine::suggest(uint32_t n, uint32_t u, int k, uint32_t* out, F forFollowing) {
+    if (k <= 0 || u >= n) return 0;
+    prepare(n);
+
+    seen[u] = epoch;  // Never suggest the asker or anyone they already follow
+    forFollowing(u, [&](uint32_t f) { seen[f] = epoch; });
+
+    touched.clear();
+    forFollowing(u, [&](uint32_t f) {
+        forFollowing(f, [&](uint32_t s) {
+            if (seen[s] == epoch) return;
+            if (!count[s]++) touched.push_back(s);
+        });
+    });
+
+    // Keep the k strongest: more paths first, then the lower ID
+    auto stronger = [](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    heap.clear();
+    for (uint32_t s : touched) {
+        pair<uint32_t, uint32_t> c(count[s], s);
+        count[s] = 0;  // Leave the counters clean for the next query
+        if ((int)heap.size() < k) {
+            heap.push_back(c);
+            push_heap(heap.begin(), heap.end(), stronger);
+        } else if (stronger(c, heap.front())) {  // Beats the weakest of the current best k
+            pop_heap(heap.begin(), heap.end(), stronger);
+            heap.back() = c;
+            push_heap(heap.begin(), heap.end(), stronger);
+        }
+    }
+
+    sort_heap(heap.begin(), heap.end(), stronger);  // Strongest first
+    for (size_t i = 0; i < heap.size(); i++) out[i] = heap[i].second;
+    return (int)heap.size();
+}
+
+class suggestCache {
+private:
+    vector<vector<uint32_t>> lists;  // Each user's cached suggestions, best first
+    vector<int> asked;             // The k each entry was made for (-1 = nothing cached)
+    uint64_t hitCt;                // Requests answered from the cache
+    uint64_t missCt;               // Requests that had to be computed
+
+public:
+    suggestCache() : hitCt(0), missCt(0) {}
+
+    bool lookup(uint32_t u, int k, vector<uint32_t>& out);  // Fill out with u's top k if they are cached (counts a hit or a miss)
+    void store(uint32_t n, uint32_t u, int k, const uint32_t* ids, int found);  // Remember u's top k of n users (found of them)
+    void invalidate(uint32_t u);   // Drop u's entry
+    void clear();                  // Drop every entry (after bulk changes); the counters are kept
+    bool active() const { return !asked.empty(); }  // Whether anything has been cached since the last clear
+    uint64_t hits() const { return hitCt; }
+    uint64_t misses() const { return missCt; }
+};
+
+bool suggestCache::lookup(uint32_t u, int k, vector<uint32_t>& out) {
+    if (u < asked.size() && asked[u] >= 0 && (k <= asked[u] || (int)lists[u].size() < asked[u])) {
+        hitCt++;
+        out.assign(lists[u].begin(), lists[u].begin() + min<size_t>(max(k, 0), lists[u].size()));
+        return true;
+    }
+    missCt++;
+    return false;
+}
+
+void suggestCache::store(uint32_t n, uint32_t u, int k, const uint32_t* ids, int found) {
+    if (asked.size() < n) {
+        asked.resize(n, -1);
+        lists.resize(n);
+    }
+    asked[u] = k;
+    lists[u].assign(ids, ids + found);
+}
+
+void suggestCache::invalidate(uint32_t u) {
+    if (u >= asked.size() || asked[u] < 0) return;
+    asked[u] = -1;
+    vector<uint32_t>().swap(lists[u]);
+}
+
+void suggestCache::clear() {
+    vector<vector<uint32_t>>().swap(lists);
+    vector<int>().swap(asked);
+}
+
+// Up to k suggestions for each of n users: ids[i]'s go in out[i * k ...] and their number in found[i]
+// ids = nullptr means users 0 ... n - 1; threads = 0 picks one thread per core
+void suggestBatch(const csrGraph& g, const uint32_t* ids, size_t n, int k, uint32_t* out, int* found, unsigned threads = 0) {
+    const size_t chunk = 64;  // Users handed out at a time
+    if (k <= 0 || !n) {
+        fill(found, found + n, 0);
+        return;
+    }
+
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)max<size_t>(1, min<size_t>(threads, (n + chunk - 1) / chunk));
+
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        suggestEngine engine;
+        for (size_t begin = next.fetch_add(chunk); begin < n; begin = next.fetch_add(chunk)) {
+            size_t end = min(n, begin + chunk);
+            for (size_t i = begin; i < end; i++) {
+                found[i] = engine.suggest(g, ids ? ids[i] : (uint32_t)i, k, out + i * k);
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.push_back(thread(worker));
+    worker();
+    for (thread& th : pool) th.join();
+}
+
+#endif
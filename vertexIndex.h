@@ -0,0 +1,30 @@
+#ifndef _VERTEXINDEX_H_
+#define _VERTEXINDEX_H_
+
+/*
+Vertex index:
+-The username -> user* index the graph keeps in its vertices member
+-Chosen at compile time:
+    -default: AVL tree (avl.h)
+    -VERTEX_INDEX_BTREE: B+-tree with 16-key nodes (btree.h), for ordered walks with fewer cache misses
+    -VERTEX_INDEX_FLAT: open-addressing hash table (flatMap.h), for the fastest point lookups
+-Every index provides the same methods, which is all the graph relies on:
+    -bulkLoad (int) (build an empty index from a batch of users, skipping repeated usernames)
+    -insert (bool), remove (bool), retrieve (user*)
+    -getArr (user**) (all users in username order; be sure to delete it!)
+    -clear (empty the index)
+-indexBench.cpp compares the three
+*/
+
+#if defined(VERTEX_INDEX_BTREE)
+#include "btree.h"
+typedef bTree vertexIndex;
+#elif defined(VERTEX_INDEX_FLAT)
+#include "flatMap.h"
+typedef flatMap vertexIndex;
+#else
+#include "avl.h"
+typedef AVL vertexIndex;
+#endif
+
+#endif